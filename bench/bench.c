@@ -0,0 +1,63 @@
+#include "bench.h"
+#include "uart_com.h"
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+static uint16_t bench_overhead;
+
+void bench_begin(void)
+{
+    uart_flush();
+    cli();
+    TCCR1B = 0;
+    TCNT1 = 0;
+    TIFR1 = (1<<TOV1);
+    TCCR1B = (1<<CS10);
+}
+
+int32_t bench_end(void)
+{
+    uint16_t t = TCNT1;
+    TCCR1B = 0;
+    uint8_t overflow = TIFR1 & (1<<TOV1);
+    sei();
+    if (overflow) {
+        return -1;
+    }
+    return (int32_t)(uint16_t)(t - bench_overhead);
+}
+
+void bench_init(void)
+{
+    uart_init(UART_BOOT_BAUD);
+    sei();
+    TCCR1A = 0;
+
+    bench_overhead = 0;
+    bench_begin();
+    int32_t empty = bench_end();
+    bench_overhead = (uint16_t)empty;
+}
+
+void bench_report(const char* name, int32_t cycles)
+{
+    uprintf_P(PSTR("BENCH,%S,%ld\r\n"), name, (long)cycles);
+}
+
+void bench_report_arg(const char* name, uint32_t arg, int32_t cycles)
+{
+    uprintf_P(PSTR("BENCH,%S[%lu],%ld\r\n"), name, (unsigned long)arg, (long)cycles);
+}
+
+void bench_done(void)
+{
+    uart_flush();
+    cli();
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    for (;;) {
+        sleep_cpu();
+    }
+}
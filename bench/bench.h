@@ -0,0 +1,79 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+ * Cycle-accurate benchmark harness.
+ *
+ * Timer1 runs at clk/1 with interrupts disabled around each measured
+ * region, so the TCNT1 delta is the exact CPU cycle count. The fixed cost
+ * of starting/stopping the timer is measured once in bench_init() and
+ * subtracted. Regions longer than 65535 cycles are reported as -1.
+ *
+ * Results go out over UART as
+ *
+ *     BENCH,<name>,<cycles>
+ *
+ * which scripts/bench_run.py collects from simavr into bench_results.json.
+ * bench_done() parks the CPU with interrupts off, which makes simavr exit.
+ */
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Set up UART and Timer1, calibrate the measurement overhead
+ */
+void bench_init(void);
+
+/**
+ * Start a measured region: drain the TX ring, disable interrupts, zero TCNT1
+ */
+void bench_begin(void);
+
+/**
+ * End a measured region and re-enable interrupts
+ * @return Cycles spent since bench_begin(), or -1 on timer overflow
+ */
+int32_t bench_end(void);
+
+/**
+ * Report one result
+ * @param name Flash string (PSTR)
+ * @param cycles Value from bench_end()
+ */
+void bench_report(const char* name, int32_t cycles);
+
+/**
+ * Report one result for a parameterised case as BENCH,<name>[<arg>],<cycles>
+ */
+void bench_report_arg(const char* name, uint32_t arg, int32_t cycles);
+
+/**
+ * Flush output and stop the simulator
+ */
+void bench_done(void) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
+
+// Measure one statement
+#define BENCH(name, stmt) do {                          \
+        bench_begin();                                  \
+        stmt;                                           \
+        int32_t bench_cycles_ = bench_end();            \
+        bench_report(PSTR(name), bench_cycles_);        \
+    } while (0)
+
+#define BENCH_ARG(name, arg, stmt) do {                 \
+        bench_begin();                                  \
+        stmt;                                           \
+        int32_t bench_cycles_ = bench_end();            \
+        bench_report_arg(PSTR(name), (arg), bench_cycles_); \
+    } while (0)
+
+#endif /* BENCH_H */
@@ -0,0 +1,54 @@
+/*
+ * Cycle comparison: avr-libc memset/memcpy/memmove/memcmp and a plain C XOR
+ * loop versus the blk.S kernels, per block size. The per-byte cost is the
+ * slope between two sizes, e.g. (cycles[128] - cycles[64]) / 64.
+ */
+
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "bench.h"
+#include "blk.h"
+
+#define BLK_BENCH_MAX 128
+
+static uint8_t buf_a[BLK_BENCH_MAX];
+static uint8_t buf_b[BLK_BENCH_MAX];
+static volatile int sink_int;
+
+// Reference implementation: what a C caller would write
+static void xor_c(void* dst, const void* src, uint16_t n)
+{
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    while (n--) {
+        *d++ ^= *s++;
+    }
+}
+
+// Odd sizes exercise every entry point into the unrolled body
+static const uint8_t sizes[] PROGMEM = { 1, 7, 16, 61, 64, 128 };
+
+int main(void)
+{
+    bench_init();
+
+    for (uint8_t i = 0; i < sizeof(sizes); i++) {
+        uint8_t n = pgm_read_byte(&sizes[i]);
+        BENCH_ARG("fill_memset", n, memset(buf_a, 0x5A, n));
+        BENCH_ARG("fill_blk", n, blk_fill(buf_a, 0x5A, n));
+        BENCH_ARG("pattern_blk", n, blk_fill_pattern(buf_a, 0xA55A, n));
+        BENCH_ARG("copy_memcpy", n, memcpy(buf_b, buf_a, n));
+        BENCH_ARG("copy_blk", n, blk_copy(buf_b, buf_a, n));
+        // Overlapping by one byte upwards: the backward path
+        BENCH_ARG("move_memmove", n, memmove(buf_a + 1, buf_a, n - 1));
+        BENCH_ARG("move_blk", n, blk_move(buf_a + 1, buf_a, n - 1));
+        // Equal buffers: the full length is scanned
+        blk_copy(buf_b, buf_a, n);
+        BENCH_ARG("compare_memcmp", n, sink_int = memcmp(buf_a, buf_b, n));
+        BENCH_ARG("compare_blk", n, sink_int = blk_compare(buf_a, buf_b, n));
+        BENCH_ARG("xor_c", n, xor_c(buf_a, buf_b, n));
+        BENCH_ARG("xor_blk", n, blk_xor(buf_a, buf_b, n));
+    }
+
+    bench_done();
+}
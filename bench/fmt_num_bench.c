@@ -0,0 +1,62 @@
+/*
+ * Cycle comparison: division-based digit loop (the old uprintf code) versus
+ * the fmt_num kernels.
+ */
+
+#include <avr/pgmspace.h>
+#include "bench.h"
+#include "fmt_num.h"
+
+static volatile char sink_byte;
+
+// Reference implementation: what uprintf did before fmt_num
+static uint8_t div_u16(char* out, uint16_t val)
+{
+    char temp[5];
+    uint8_t n = 0;
+    do {
+        temp[n++] = '0' + (val % 10);
+        val /= 10;
+    } while (val > 0);
+    for (uint8_t i = 0; i < n; i++) {
+        out[i] = temp[n - 1 - i];
+    }
+    return n;
+}
+
+static uint8_t div_u32(char* out, uint32_t val)
+{
+    char temp[10];
+    uint8_t n = 0;
+    do {
+        temp[n++] = '0' + (val % 10);
+        val /= 10;
+    } while (val > 0);
+    for (uint8_t i = 0; i < n; i++) {
+        out[i] = temp[n - 1 - i];
+    }
+    return n;
+}
+
+static const uint16_t values16[] PROGMEM = { 0, 9, 255, 1234, 65535 };
+static const uint32_t values32[] PROGMEM = { 0, 65535, 1000000UL, 123456789UL, 4294967295UL };
+
+int main(void)
+{
+    char buf[FMT_NUM_MAX_DIGITS];
+
+    bench_init();
+
+    for (uint8_t i = 0; i < sizeof(values16) / sizeof(values16[0]); i++) {
+        uint16_t v = pgm_read_word(&values16[i]);
+        BENCH_ARG("u16_div", v, sink_byte = buf[div_u16(buf, v) - 1]);
+        BENCH_ARG("u16_fmt", v, sink_byte = buf[fmt_u16(buf, v) - 1]);
+    }
+    for (uint8_t i = 0; i < sizeof(values32) / sizeof(values32[0]); i++) {
+        uint32_t v = pgm_read_dword(&values32[i]);
+        BENCH_ARG("u32_div", v, sink_byte = buf[div_u32(buf, v) - 1]);
+        BENCH_ARG("u32_fmt", v, sink_byte = buf[fmt_u32(buf, v) - 1]);
+    }
+
+    bench_done();
+}
@@ -0,0 +1,21 @@
+/*
+ * Cost of the prof.h probes. The bench harness owns Timer1 here, so the
+ * probes read the same clock the measurement does; prof_init() is not
+ * called and the overhead calibration stays 0. prof_fold is one queued
+ * span folded into the statistics, the work PROF_END no longer does.
+ */
+
+#include "bench.h"
+#include "prof.h"
+
+int main(void)
+{
+    bench_init();
+    prof_reset();
+
+    BENCH("prof_now", (void)prof_now());
+    BENCH("prof_probe", { PROF_BEGIN(PROF_LOOP); PROF_END(PROF_LOOP); });
+    BENCH("prof_fold", { prof_push(PROF_LOOP, 1000); prof_fold(); });
+
+    bench_done();
+}
@@ -0,0 +1,34 @@
+/*
+ * Reset-to-main time and the demo buffer fill.
+ *
+ * Timer1 is started from .init0, the first code after the reset vector, and
+ * read as the first thing in main(), so the count covers the whole C
+ * runtime startup (stack setup and painting, .data copy, .bss clear).
+ * Built twice: bench_startup with the avr-libc loops and bench_startup_fast
+ * with src/crt_fast.S (-DFAST_STARTUP). Both include the copy of the
+ * partitions' initial images; fill_buffers() reloads those from flash.
+ */
+
+#include <avr/io.h>
+#include "bench.h"
+#include "buffers.h"
+
+__attribute__((naked, used, section(".init0")))
+void bench_start_timer(void)
+{
+    TCCR1B = (1<<CS10);
+}
+
+int main(void)
+{
+    uint16_t startup = TCNT1;
+    uint8_t overflow = TIFR1 & (1<<TOV1);
+    TCCR1B = 0;
+
+    bench_init();
+    bench_report(PSTR("startup_to_main"), overflow ? -1 : (int32_t)startup);
+
+    BENCH("fill_buffers", fill_buffers());
+
+    bench_done();
+}
@@ -0,0 +1,62 @@
+/*
+ * uprintf_P versus UFMT on the same status lines. Each line is timed with
+ * interrupts off (the TX ring absorbs it). Flash per call site is the size
+ * of the line_* / ptr_* functions: `make bench-ufmt` lists them.
+ */
+
+#include <avr/pgmspace.h>
+#include "bench.h"
+#include "uart_com.h"
+#include "ufmt.hpp"
+
+static uint8_t sig[3] = { 0x1E, 0x95, 0x0F };
+static uint16_t counter = 12345;
+static uint32_t uptime = 3600000UL;
+
+__attribute__((noinline)) void line_uprintf(void)
+{
+    uprintf_P(PSTR("sig=%X %X %X count=%u up=%lu\r\n"), sig[0], sig[1], sig[2], counter, uptime);
+}
+
+__attribute__((noinline)) void line_ufmt(void)
+{
+    UFMT("sig=%X %X %X count=%u up=%lu\r\n", sig[0], sig[1], sig[2], counter, uptime);
+}
+
+// Arrays bind by reference and must still pass as pointers
+static_assert(ufmt::detail::accepts<ufmt::detail::strip<char[32]>::type>(ufmt::detail::conv::s),
+              "char[N] must be accepted by %s");
+static_assert(ufmt::detail::accepts<ufmt::detail::strip<const char[5]>::type>(ufmt::detail::conv::s),
+              "string literals must be accepted by %s");
+static_assert(ufmt::detail::accepts<ufmt::detail::strip<uint8_t[3]>::type>(ufmt::detail::conv::p),
+              "arrays must be accepted by %p");
+
+static char name[8] = "ufmt";
+
+__attribute__((noinline)) void array_ufmt(void)
+{
+    UFMT("%s %s %p\r\n", "literal", name, sig);
+}
+
+__attribute__((noinline)) void ptr_uprintf(void)
+{
+    uprintf_P(PSTR("sig@%p counter@%p\r\n"), (void*)sig, (void*)&counter);
+}
+
+__attribute__((noinline)) void ptr_ufmt(void)
+{
+    UFMT("sig@%p counter@%p\r\n", (void*)sig, (void*)&counter);
+}
+
+int main(void)
+{
+    bench_init();
+
+    BENCH("status_line_uprintf", line_uprintf());
+    BENCH("status_line_ufmt", line_ufmt());
+    BENCH("pointers_uprintf", ptr_uprintf());
+    BENCH("pointers_ufmt", ptr_ufmt());
+    BENCH("arrays_ufmt", array_ufmt());
+
+    bench_done();
+}
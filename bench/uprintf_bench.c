@@ -0,0 +1,39 @@
+/*
+ * Cost of each uprintf conversion and of uart_print, measured into the TX
+ * ring (interrupts off, so the UART drain is not included).
+ */
+
+#include <avr/pgmspace.h>
+#include "bench.h"
+#include "uart_com.h"
+
+static int val_int = -12345;
+static unsigned int val_uint = 54321;
+static long val_long = -1234567890L;
+static unsigned long val_ulong = 4000000000UL;
+static const char val_str[] = "telemetry";
+static const char val_str_P[] PROGMEM = "flash string";
+
+int main(void)
+{
+    bench_init();
+
+    BENCH("uart_print_16", uart_print("0123456789abcdef"));
+    BENCH("uart_print_P_16", uart_print_P(PSTR("0123456789abcdef")));
+    BENCH("uprintf_literal_16", uprintf("0123456789abcdef"));
+    BENCH("uprintf_P_literal_16", uprintf_P(PSTR("0123456789abcdef")));
+    BENCH("uprintf_d", uprintf("%d", val_int));
+    BENCH("uprintf_u", uprintf("%u", val_uint));
+    BENCH("uprintf_x", uprintf("%x", val_uint));
+    BENCH("uprintf_X", uprintf("%X", val_uint));
+    BENCH("uprintf_ld", uprintf("%ld", val_long));
+    BENCH("uprintf_lu", uprintf("%lu", val_ulong));
+    BENCH("uprintf_lx", uprintf("%lx", val_ulong));
+    BENCH("uprintf_c", uprintf("%c", 'Z'));
+    BENCH("uprintf_s", uprintf("%s", val_str));
+    BENCH("uprintf_S", uprintf("%S", val_str_P));
+    BENCH("uprintf_p", uprintf("%p", (void*)&val_int));
+    BENCH("uprintf_percent", uprintf("%%"));
+
+    bench_done();
+}
@@ -94,7 +94,6 @@ extern uint8_t __data_start;
 extern uint8_t __data_end;
 extern uint8_t __bss_start;
 extern uint8_t __bss_end;
-extern uint8_t __heap_start;
 extern uint8_t __serial_start;
 extern uint8_t __serial_end;
 extern uint8_t __fixed_start;
@@ -104,11 +103,13 @@ extern uint8_t __fixed_end;
  * Helper Functions
  *****************************************************************************/
 
-// Calculate free SRAM (between heap and stack)
+// Calculate free SRAM (between the end of static data and the stack).
+// There is no heap in these layouts, so no __heap_start/__brkval: _end
+// marks the top of .noinit and everything above it belongs to the stack.
 int get_free_ram(void) {
-    extern int __heap_start, *__brkval;
-    int v;
-    return (int) &v - (__brkval == 0 ? (int) &__heap_start : (int) __brkval);
+    extern uint8_t _end;
+    uint8_t v;
+    return (int) &v - (int) &_end;
 }
 
 // Print memory layout (requires UART setup)
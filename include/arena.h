@@ -0,0 +1,108 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Scoped bump (arena) allocator for per-iteration scratch memory.
+ *
+ * Allocation moves a pointer forward; nothing is freed individually.
+ * arena_mark()/arena_rollback() release everything allocated after a mark
+ * (nested scopes), arena_reset() releases everything (end of a main-loop
+ * iteration). Not ISR-safe: use it from the main context only.
+ *
+ * arena_frame is the shared instance over the free tail of the
+ * .buffer_640 partition, [__buffer_640_free, __buffer_640_end); call
+ * arena_frame_init() once at startup.
+ *
+ * With ARENA_DEBUG defined, released bytes are overwritten with
+ * ARENA_POISON so use-after-reset shows up as obviously bad data.
+ */
+
+#ifndef ARENA_ALIGN
+#define ARENA_ALIGN 1   // default alignment; AVR needs none, raise for DMA-like users
+#endif
+
+#define ARENA_POISON 0xA5
+
+typedef struct {
+    uint8_t* base;
+    uint8_t* end;
+    uint8_t* top;
+    uint16_t peak;      // highest number of bytes in use since init
+    uint16_t failures;  // allocations that did not fit
+} arena_t;
+
+typedef uint16_t arena_mark_t;
+
+extern arena_t arena_frame;
+
+/**
+ * Manage the region [base, end)
+ */
+void arena_init(arena_t* a, void* base, void* end);
+
+/**
+ * Initialize arena_frame over the free tail of .buffer_640
+ */
+void arena_frame_init(void);
+
+/**
+ * Allocate size bytes aligned to align (a power of two)
+ * @return Pointer, or NULL if the arena is exhausted
+ */
+void* arena_alloc_aligned(arena_t* a, uint16_t size, uint8_t align);
+
+/**
+ * Allocate size bytes with ARENA_ALIGN alignment
+ * @return Pointer, or NULL if the arena is exhausted
+ */
+static inline void* arena_alloc(arena_t* a, uint16_t size)
+{
+    return arena_alloc_aligned(a, size, ARENA_ALIGN);
+}
+
+/**
+ * Remember the current top for a later arena_rollback()
+ */
+static inline arena_mark_t arena_mark(const arena_t* a)
+{
+    return (arena_mark_t)(a->top - a->base);
+}
+
+/**
+ * Release everything allocated since mark
+ */
+void arena_rollback(arena_t* a, arena_mark_t mark);
+
+/**
+ * Release everything
+ */
+static inline void arena_reset(arena_t* a)
+{
+    arena_rollback(a, 0);
+}
+
+/**
+ * Bytes currently allocated
+ */
+static inline uint16_t arena_used(const arena_t* a)
+{
+    return (uint16_t)(a->top - a->base);
+}
+
+/**
+ * Total capacity in bytes
+ */
+static inline uint16_t arena_capacity(const arena_t* a)
+{
+    return (uint16_t)(a->end - a->base);
+}
+
+/**
+ * Print capacity, current use, peak and failures over UART
+ */
+void arena_print_stats(const arena_t* a);
+
+#endif /* ARENA_H */
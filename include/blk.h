@@ -0,0 +1,67 @@
+#ifndef BLK_H
+#define BLK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Block fill/copy/compare kernels (src/blk.S).
+ *
+ * Drop-in replacements for memset/memcpy/memmove/memcmp plus a pattern fill
+ * and an in-place XOR. Each kernel runs an 8x unrolled ST X+ / LD Y+ body
+ * and enters it part-way for the n % 8 tail bytes, so the per-byte cost is
+ * the bare load/store time plus a fixed 21-23 cycle setup (counted in
+ * src/blk.S):
+ *
+ *     kernel            cycles/byte   avr-libc
+ *     blk_fill          2.5           memset   6
+ *     blk_fill_pattern  2.5           -
+ *     blk_copy          4.5           memcpy   8
+ *     blk_move          4.5           memmove  8
+ *     blk_compare       6.5           memcmp  10
+ *     blk_xor           7.5           C loop  ~14 at -Os
+ *
+ * n may be 0. Lengths are 16-bit, which covers the whole SRAM.
+ * bench/blk_bench.c measures all of them against avr-libc.
+ */
+
+/**
+ * Set dst[0..n) to value
+ */
+void blk_fill(void* dst, uint8_t value, uint16_t n);
+
+/**
+ * Fill dst[0..n) with a repeating 2-byte pattern, stored little-endian:
+ * even offsets get the low byte, odd offsets the high byte
+ */
+void blk_fill_pattern(void* dst, uint16_t pattern, uint16_t n);
+
+/**
+ * Copy src[0..n) to dst; the regions must not overlap unless dst < src
+ */
+void blk_copy(void* dst, const void* src, uint16_t n);
+
+/**
+ * Copy src[0..n) to dst; the regions may overlap
+ */
+void blk_move(void* dst, const void* src, uint16_t n);
+
+/**
+ * Compare a[0..n) with b[0..n)
+ * @return a[i] - b[i] at the first differing byte, 0 if all are equal
+ */
+int blk_compare(const void* a, const void* b, uint16_t n);
+
+/**
+ * dst[i] ^= src[i] for i in [0, n)
+ */
+void blk_xor(void* dst, const void* src, uint16_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLK_H */
@@ -0,0 +1,25 @@
+#ifndef BUFFERS_H
+#define BUFFERS_H
+
+#include <stdint.h>
+#include "uart_com.h"
+#include "partitions.h"
+
+// The UART RX/TX rings own the tail of the 128/640-byte partitions;
+// the whole 256-byte partition belongs to the pool allocator (pool.h) and
+// the unclaimed tail of the 640-byte one to the frame arena (arena.h)
+#define BUFFER_128_APP_SIZE (PARTITION_BUFFER_128_SIZE - UART_RX_RING_SIZE)
+#define BUFFER_640_APP_SIZE 128   // the bytes after it and the TX ring are the arena
+
+// Application views of the static buffer partitions (see linkers/partitions.cfg)
+extern uint8_t buffer_128[BUFFER_128_APP_SIZE];
+extern uint8_t buffer_640[BUFFER_640_APP_SIZE];
+
+/**
+ * Restore the application buffers' demo pattern. They start out with it:
+ * it is their initial partition image, so this only reloads the image
+ * from flash.
+ */
+void fill_buffers(void);
+
+#endif /* BUFFERS_H */
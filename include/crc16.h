@@ -0,0 +1,27 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+
+/*
+ * CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF, no reflection, no final
+ * XOR), table-driven with the 512-byte table in flash.
+ */
+
+#define CRC16_INIT 0xFFFF
+
+/**
+ * Feed bytes into a running CRC
+ * @param crc Current value (CRC16_INIT for a new message)
+ * @param data Bytes to add
+ * @param len Number of bytes
+ * @return Updated CRC
+ */
+uint16_t crc16_update(uint16_t crc, const void* data, uint16_t len);
+
+/**
+ * Feed a single byte into a running CRC
+ */
+uint16_t crc16_update_byte(uint16_t crc, uint8_t byte);
+
+#endif /* CRC16_H */
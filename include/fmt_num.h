@@ -0,0 +1,71 @@
+#ifndef FMT_NUM_H
+#define FMT_NUM_H
+
+#include <stdint.h>
+#include <limits.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Division-free integer to text conversion.
+ *
+ * avr-gcc lowers `val % 10` / `val / 10` to calls into __udivmodhi4 and
+ * __udivmodsi4, which cost hundreds of cycles per digit. These kernels
+ * produce decimal digits by repeatedly subtracting powers of ten read from
+ * a flash table (at most 9 subtractions per digit) and hex digits by
+ * shifting.
+ *
+ * Every function writes digits most significant first into out, without a
+ * terminator, and returns the number of characters written. out must hold
+ * at least FMT_NUM_MAX_DIGITS characters.
+ */
+
+#define FMT_NUM_MAX_DIGITS 11   // "-2147483648"
+
+/**
+ * Format an 8-bit unsigned value in decimal (1-3 digits)
+ */
+uint8_t fmt_u8(char* out, uint8_t val);
+
+/**
+ * Format a 16-bit unsigned value in decimal (1-5 digits)
+ */
+uint8_t fmt_u16(char* out, uint16_t val);
+
+/**
+ * Format a 32-bit unsigned value in decimal (1-10 digits)
+ */
+uint8_t fmt_u32(char* out, uint32_t val);
+
+/**
+ * Format a 16-bit signed value in decimal, with a leading '-' if negative
+ */
+uint8_t fmt_i16(char* out, int16_t val);
+
+/**
+ * Format a 32-bit signed value in decimal, with a leading '-' if negative
+ */
+uint8_t fmt_i32(char* out, int32_t val);
+
+/**
+ * Format a 32-bit value in hexadecimal without leading zeros
+ * @param upper Non-zero for 'A'-'F', zero for 'a'-'f'
+ */
+uint8_t fmt_hex32(char* out, uint32_t val, uint8_t upper);
+
+// Native int width (16 bits on AVR, wider on host builds)
+#if UINT_MAX == 0xFFFF
+#define fmt_uint(out, val) fmt_u16((out), (val))
+#define fmt_int(out, val)  fmt_i16((out), (val))
+#else
+#define fmt_uint(out, val) fmt_u32((out), (val))
+#define fmt_int(out, val)  fmt_i32((out), (val))
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FMT_NUM_H */
@@ -0,0 +1,107 @@
+#ifndef KV_H
+#define KV_H
+
+#include <stdint.h>
+
+/*
+ * Log-structured key-value store over the EEPROM.
+ *
+ * The store owns a KV_PAGES x KV_PAGE_SIZE array in .eeprom (the whole
+ * 1 KB by default). Each page starts with a sequence byte; records are
+ * appended behind it:
+ *
+ *     [key][len][value: len bytes][crc16 lo][crc16 hi]
+ *
+ * A key byte of 0xFF ends a page. Every append first writes that end
+ * marker behind the new record and then the record itself, so records
+ * left from a page's previous lap are never replayed, and a torn write
+ * loses at most the record being written. Updates always append and pages
+ * are reused in ring order, so wear spreads over every cell.
+ * Before the head moves into a page, the live records of the page after
+ * it are rewritten at the head (evacuated), so reusing a page never drops
+ * the latest version of a key.
+ *
+ * kv_init() replays the log once at boot into a RAM slot per key holding
+ * the current value and its EEPROM address. Keys are small integers that
+ * index the slots directly, so kv_get() is O(1) and never touches the
+ * EEPROM. kv_set() only updates the slot and marks it dirty: repeated
+ * updates between two write-backs coalesce into one record, and writing
+ * the current value is free. kv_poll(), called from the main loop, hands
+ * the next dirty record to the EE_READY interrupt. The interrupt writes
+ * it byte by byte and skips bytes that already hold the right value, so
+ * no call ever waits on the ~3.4 ms EEPROM write cycle. Main context only,
+ * except the interrupt itself.
+ */
+
+#ifndef KV_MAX_KEYS
+#define KV_MAX_KEYS 8           // keys 0 .. KV_MAX_KEYS-1
+#endif
+
+#ifndef KV_MAX_VALUE
+#define KV_MAX_VALUE 8          // bytes per value
+#endif
+
+#ifndef KV_PAGE_SIZE
+#define KV_PAGE_SIZE 64
+#endif
+
+#ifndef KV_PAGES
+#define KV_PAGES 16
+#endif
+
+typedef struct {
+    uint8_t head_page;          // page records are appended to
+    uint8_t head_seq;           // its sequence number
+    uint8_t head_used;          // bytes used in it, header included
+    uint8_t dirty;              // keys waiting for write-back
+    uint16_t records;           // records written since boot
+    uint16_t pages_opened;      // pages (re)started since boot
+    uint16_t bytes_written;     // EEPROM cells actually programmed
+    uint16_t bytes_skipped;     // cells that already held the value
+} kv_stats_t;
+
+/**
+ * Replay the EEPROM log into the RAM index. Call once before anything else.
+ */
+void kv_init(void);
+
+/**
+ * Copy the current value of key into buf
+ * @param size Capacity of buf
+ * @return Value length, or -1 if the key has no value or buf is too small
+ */
+int8_t kv_get(uint8_t key, void* buf, uint8_t size);
+
+/**
+ * Set key to data[0..len) in RAM; the EEPROM is updated by kv_poll()
+ * @return 0 on success, -1 if key or len is out of range
+ */
+int8_t kv_set(uint8_t key, const void* data, uint8_t len);
+
+/**
+ * Start writing back the next dirty record if the EEPROM is idle.
+ * Call regularly from the main loop; never blocks.
+ */
+void kv_poll(void);
+
+/**
+ * @return Nonzero while dirty keys or an EEPROM write are outstanding
+ */
+uint8_t kv_busy(void);
+
+/**
+ * Write back everything now (blocks; use before an intentional reset)
+ */
+void kv_flush(void);
+
+/**
+ * Snapshot of head position and write counters
+ */
+void kv_get_stats(kv_stats_t* out);
+
+/**
+ * Print kv_get_stats() over UART
+ */
+void kv_print_stats(void);
+
+#endif /* KV_H */
@@ -0,0 +1,52 @@
+/* Generated by scripts/gen_partitions.py from linkers/partitions.cfg - do not edit */
+#ifndef PARTITIONS_H
+#define PARTITIONS_H
+
+// Data-space addresses (as C pointers see them, without the 0x800000 offset)
+#define SRAM_ORIGIN 0x0100
+#define SRAM_SIZE 2048
+
+#define PARTITION_BUFFER_128_ORIGIN 0x0100
+#define PARTITION_BUFFER_128_SIZE 128
+#define PARTITION_BUFFER_256_ORIGIN 0x0180
+#define PARTITION_BUFFER_256_SIZE 256
+#define PARTITION_BUFFER_640_ORIGIN 0x0280
+#define PARTITION_BUFFER_640_SIZE 640
+
+// .data/.bss/.noinit and the stack
+#define PARTITION_DATA_ORIGIN 0x0500
+#define PARTITION_DATA_SIZE 1024
+#define PARTITION_DATA_MIN 512
+
+// Every partition, in address order (for .irp in assembly)
+#define PARTITION_NAMES buffer_128, buffer_256, buffer_640
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+// Linker-provided bounds (see partitions_sections.ld)
+extern uint8_t __buffer_128_start[PARTITION_BUFFER_128_SIZE];
+extern uint8_t __buffer_128_free[];
+extern uint8_t __buffer_128_end[];
+extern uint8_t __buffer_256_start[PARTITION_BUFFER_256_SIZE];
+extern uint8_t __buffer_256_free[];
+extern uint8_t __buffer_256_end[];
+extern uint8_t __buffer_640_start[PARTITION_BUFFER_640_SIZE];
+extern uint8_t __buffer_640_free[];
+extern uint8_t __buffer_640_end[];
+
+// Initial images (see partitions_sections.ld): SRAM bounds, flash copy
+extern uint8_t __buffer_128_image_start[];
+extern uint8_t __buffer_128_image_end[];
+extern const uint8_t __buffer_128_image_load[];
+extern uint8_t __buffer_256_image_start[];
+extern uint8_t __buffer_256_image_end[];
+extern const uint8_t __buffer_256_image_load[];
+extern uint8_t __buffer_640_image_start[];
+extern uint8_t __buffer_640_image_end[];
+extern const uint8_t __buffer_640_image_load[];
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* PARTITIONS_H */
@@ -0,0 +1,57 @@
+#ifndef PCPROF_H
+#define PCPROF_H
+
+/*
+ * Statistical PC-sampling profiler (make PCPROF=on, -DPCPROF).
+ *
+ * Timer2 in CTC mode interrupts at PCPROF_HZ. The compare ISR
+ * (src/pcprof_isr.S) reads the interrupted return address off the stack
+ * and counts it into one of PCPROF_BINS 16-bit bins. The bins cover flash
+ * up to _etext, and pcprof_start() picks the smallest power-of-two bin
+ * size that fits. The ISR costs ~85 cycles per sample (~0.6 % of the CPU).
+ *
+ * pcprof_stream() prints the samples since the previous call and clears
+ * the bins:
+ *
+ *     PCPROF,B,<bin bytes>,<sample rate>
+ *     PCPROF,S,<bin start address, hex>,<samples>   one per non-empty bin
+ *     PCPROF,E,<samples outside the bins>
+ *
+ * scripts/pcprof_report.py maps the bins back to functions with avr-nm or
+ * the link map and prints a flat profile.
+ *
+ * An interrupt cannot be taken while interrupts are disabled, so time in
+ * cli regions and other ISRs is charged to the instruction after the sei
+ * or reti. The rate is deliberately not a divisor of 1 kHz, so periodic
+ * 1 ms work is not sampled in lockstep.
+ */
+
+#define PCPROF_BINS 128
+#define PCPROF_PRESCALE 128
+#ifndef PCPROF_OCR
+#define PCPROF_OCR 112          // 16 MHz / 128 / 113 = 1106 Hz
+#endif
+#define PCPROF_HZ (F_CPU / PCPROF_PRESCALE / (PCPROF_OCR + 1))
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+/**
+ * Clear the bins and start sampling
+ */
+void pcprof_start(void);
+
+/**
+ * Stop sampling; the bins keep their counts
+ */
+void pcprof_stop(void);
+
+/**
+ * Print and clear the bins (format above)
+ */
+void pcprof_stream(void);
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* PCPROF_H */
@@ -0,0 +1,76 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Fixed-block pool allocator over the .buffer_256 partition.
+ *
+ * Storage is [__buffer_256_free, __buffer_256_end), i.e. whatever part of
+ * the partition no object claims, so the linker script stays the single
+ * source of truth. It is carved once at pool_init() into the size classes
+ * below, each with its own free list. Alloc and free are O(1), never
+ * fragment, and run with interrupts masked so they are ISR-safe. A bitmap
+ * with one bit per block records which blocks are out, so pool_free()
+ * can reject a double free.
+ *
+ * POOL_CLASSES lists (block size, block count) pairs, smallest first.
+ * Block sizes must be at least sizeof(void*).
+ */
+
+#ifndef POOL_CLASSES
+#define POOL_CLASSES(X) \
+    X(16, 8)            \
+    X(32, 2)            \
+    X(64, 1)
+#endif
+
+typedef struct {
+    uint16_t block_size;
+    uint8_t blocks;
+    uint8_t used;
+    uint8_t peak;
+    uint16_t failures;  // requests this class could not serve
+} pool_stats_t;
+
+/**
+ * Carve the partition into blocks. Must run before any pool_alloc().
+ * @return 0 on success, -1 if POOL_CLASSES does not fit the partition
+ */
+int8_t pool_init(void);
+
+/**
+ * Allocate a block of at least size bytes from the smallest class that has
+ * one free
+ * @param size Requested size in bytes
+ * @return Block pointer, or NULL if no class can serve the request
+ */
+void* pool_alloc(uint16_t size);
+
+/**
+ * Return a block to its class. NULL is ignored. A pointer that is not an
+ * allocated block (double free, offset or foreign pointer) is rejected
+ * and traced as TRACE_EV_FREE; the pool stays consistent.
+ * @param block Pointer from pool_alloc()
+ */
+void pool_free(void* block);
+
+/**
+ * Number of size classes
+ */
+uint8_t pool_class_count(void);
+
+/**
+ * Snapshot of one class's counters
+ * @param cls Class index (0 = smallest)
+ * @param out Destination
+ */
+void pool_get_stats(uint8_t cls, pool_stats_t* out);
+
+/**
+ * Print per-class usage and peak over UART
+ */
+void pool_print_stats(void);
+
+#endif /* POOL_H */
@@ -0,0 +1,149 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+/*
+ * Cycle-counting probes with on-device statistics.
+ *
+ * Timer1 free-runs at clk/1 from prof_init(); its overflow interrupt
+ * extends TCNT1 to a 32-bit cycle clock (wraps after ~268 s at 16 MHz,
+ * which only limits a single probe span). A probe is a pair
+ *
+ *     PROF_BEGIN(PROF_CMD);
+ *     ...
+ *     PROF_END(PROF_CMD);
+ *
+ * in the same scope. Both halves are inline and call nothing, so a probe
+ * in an ISR does not make the compiler save every call-clobbered
+ * register. PROF_BEGIN reads the clock. PROF_END reads it again and
+ * queues the raw span in the probe's PROF_QUEUE-entry ring under a short
+ * cli. prof_fold() moves the queued spans into the statistics: count,
+ * min/max/sum and a log2 histogram. The main loop calls it on every pass,
+ * and prof_print_stats() calls it before printing. When more than
+ * PROF_QUEUE spans arrive between two folds, the oldest ones are
+ * overwritten and counted as lost.
+ *
+ * bench_prof (make bench) measures prof_now(), a whole empty probe and a
+ * fold of one span. The span of an empty probe is calibrated out in
+ * prof_init(). Probes work in any context and stay in production builds.
+ *
+ * The tables are in .noinit (STARTUP_DONTCARE): prof_init() clears them,
+ * so they cost no startup time.
+ *
+ * Timer1 belongs to the profiler in the firmware and to the bench
+ * harness (bench/bench.h) in benchmark images, which never call
+ * prof_init().
+ */
+
+// Histogram: bucket 0 holds spans below 2^PROF_HIST_SHIFT cycles, bucket k
+// spans in [2^(k-1+SHIFT), 2^(k+SHIFT)), the last bucket everything above
+#ifndef PROF_HIST_SHIFT
+#define PROF_HIST_SHIFT 4
+#endif
+#define PROF_HIST_BUCKETS 16
+
+// Probe ids and their names in the dump
+#define PROF_PROBES(X)                                  \
+    X(PROF_LOOP,   "loop")      /* main loop body */    \
+    X(PROF_STATUS, "status")    /* status lines */      \
+    X(PROF_CMD,    "cmd")       /* command handling */  \
+    X(PROF_KV_ISR, "kv_isr")    /* EE_READY interrupt */
+
+#define PROF_ID_(id, name) id,
+enum {
+    PROF_PROBES(PROF_ID_)
+    PROF_COUNT
+};
+#undef PROF_ID_
+
+// Spans queued per probe between folds, power of two
+#ifndef PROF_QUEUE
+#define PROF_QUEUE 4
+#endif
+
+typedef struct {
+    uint32_t count;             // spans in sum/min/max/hist
+    uint16_t lost;              // spans overwritten before a fold, not in count
+    uint32_t min;               // UINT32_MAX until the first span
+    uint32_t max;
+    uint64_t sum;
+    uint16_t hist[PROF_HIST_BUCKETS]; // saturating
+} prof_stats_t;
+
+typedef struct {
+    uint8_t head;               // written by PROF_END only
+    uint8_t tail;               // written by prof_fold() only
+    uint32_t span[PROF_QUEUE];
+} prof_queue_t;
+
+extern prof_stats_t prof_table[PROF_COUNT];
+extern prof_queue_t prof_queue[PROF_COUNT];
+
+// High word of the cycle clock, counted by the Timer1 overflow interrupt
+extern volatile uint16_t prof_ovf;
+
+/**
+ * Current value of the 32-bit cycle clock (any context)
+ */
+static inline uint32_t prof_now(void)
+{
+    uint16_t lo;
+    uint16_t hi;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        lo = TCNT1;
+        hi = prof_ovf;
+        // Overflowed, but the interrupt has not run yet
+        if ((TIFR1 & (1<<TOV1)) && lo < 0x8000) {
+            hi++;
+        }
+    }
+    return ((uint32_t)hi << 16) | lo;
+}
+
+/**
+ * Queue one raw span for a probe (any context); id is a constant at every
+ * PROF_END, so the queue address folds away
+ */
+static inline void prof_push(uint8_t id, uint32_t span)
+{
+    prof_queue_t* q = &prof_queue[id];
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        uint8_t head = q->head;
+        q->span[head & (PROF_QUEUE - 1)] = span;
+        q->head = head + 1;
+    }
+}
+
+#define PROF_BEGIN(id) uint32_t prof_t0_##id = prof_now()
+#define PROF_END(id)   prof_push((id), prof_now() - prof_t0_##id)
+
+/**
+ * Start Timer1 as the cycle clock, calibrate an empty probe and clear the
+ * tables. Replaces any other Timer1 setup.
+ */
+void prof_init(void);
+
+/**
+ * Move every queued span into the statistics (main context; call often
+ * enough that no queue overflows, e.g. once per main-loop pass)
+ */
+void prof_fold(void);
+
+/**
+ * Clear every probe's statistics and queue
+ */
+void prof_reset(void);
+
+/**
+ * Fold, then print one line per probe that has spans: folded spans, lost
+ * spans, min/avg/max cycles over the folded ones and the non-empty histogram buckets as
+ * <lower bound>:<count>
+ */
+void prof_print_stats(void);
+
+#endif /* PROF_H */
@@ -0,0 +1,47 @@
+#ifndef STACK_H
+#define STACK_H
+
+/*
+ * Stack high-water monitoring for the heapless layout.
+ *
+ * buffer_no_heap.ld has no heap: everything between the end of static data
+ * (__noinit_end) and the stack pointer belongs to the stack, which grows
+ * down from RAMEND. src/stack_paint.S paints that gap with STACK_CANARY
+ * from .init3 (right after SP is set up, before .data/.bss are touched);
+ * stack_unused() later counts how many canary bytes survived above
+ * __noinit_end, i.e. the margin the deepest call chain so far left.
+ *
+ * Only STACK_CANARY is visible to assembly; stack_paint.S includes this
+ * header for it.
+ */
+
+#define STACK_CANARY 0xC5
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+/**
+ * Canary bytes still intact above __noinit_end (assembly scanner)
+ * @return Bytes the stack has never reached since reset
+ */
+uint16_t stack_unused(void);
+
+/**
+ * Bytes between __noinit_end and the current stack pointer
+ */
+uint16_t stack_free(void);
+
+/**
+ * Deepest stack use since reset, in bytes below RAMEND
+ */
+uint16_t stack_peak(void);
+
+/**
+ * Print stack bounds, current free bytes, peak use and margin over UART
+ */
+void stack_print_stats(void);
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* STACK_H */
@@ -0,0 +1,27 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+/*
+ * C runtime startup options.
+ *
+ * STARTUP=fast (-DFAST_STARTUP) links src/crt_fast.S in place of the
+ * generic avr-libc .data copy and .bss clear; see there for the numbers.
+ *
+ * STARTUP_DONTCARE places a zero-initialized object in .noinit instead of
+ * .bss, so no startup code touches it. Only use it for objects that are
+ * fully written before they are read (e.g. set up by an init function);
+ * their contents after reset are whatever was in RAM.
+ *
+ * PARTITION_IMAGE(part) places an initialized object in the initial image
+ * of a buffer partition (e.g. PARTITION_IMAGE(buffer_640)). The linker
+ * stores the image in flash and src/partition_images.S copies it in at
+ * startup, so lookup tables and calibration blocks need no fill loop.
+ * Tables that are never written belong in PROGMEM instead: they cost no
+ * SRAM and no startup time.
+ */
+
+#define STARTUP_DONTCARE __attribute__((section(".noinit.dontcare")))
+
+#define PARTITION_IMAGE(part) __attribute__((section("." #part ".image")))
+
+#endif /* STARTUP_H */
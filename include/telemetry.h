@@ -0,0 +1,80 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+/*
+ * COBS-framed binary telemetry over the UART TX ring.
+ *
+ * Frame before encoding:
+ *
+ *     [type][seq][len][payload: len bytes][crc16 lo][crc16 hi]
+ *
+ * seq increments by one per frame so the host can count drops; the CRC
+ * (crc16.h) covers type..payload. The frame is COBS-encoded, so it contains
+ * no zero bytes, and terminated by a single 0x00 delimiter. Encoding runs
+ * straight from the caller's memory into the TX ring with no frame buffer.
+ * Frames must not be sent concurrently (main context only).
+ */
+
+#define TM_MAX_PAYLOAD 250
+
+// Frame types
+#define TM_TYPE_SIGNATURE 0x01  // 3 signature bytes
+#define TM_TYPE_ADDRESSES 0x02  // little-endian u16 addresses
+#define TM_TYPE_BUFFER    0x03  // [partition][offset lo][offset hi][data...]
+#define TM_TYPE_STATS     0x04  // UART counters, see telemetry_send_stats()
+#define TM_TYPE_TRACE     0x05  // [cause][state][head][count][boots][ring], trace.h
+
+// Partition ids used in TM_TYPE_BUFFER frames
+#define TM_PART_128 0
+#define TM_PART_256 1
+#define TM_PART_640 2
+
+// Data bytes per TM_TYPE_BUFFER frame
+#ifndef TM_BUFFER_CHUNK
+#define TM_BUFFER_CHUNK 128
+#endif
+
+// One piece of a frame for telemetry_cobs_send()
+typedef struct {
+    const void* ptr;
+    uint8_t len;
+} tm_seg_t;
+
+/**
+ * COBS-encode the concatenation of count segments into the TX ring and
+ * terminate it with 0x00. Raw framing only: telemetry_send() adds the
+ * header and CRC; ULOG_DEFERRED records use it with their own layout.
+ * @param seg Segments in frame order (a zero len skips one)
+ * @param count Number of segments
+ */
+void telemetry_cobs_send(const tm_seg_t* seg, uint8_t count);
+
+/**
+ * Send one frame whose payload is hdr followed by data (either may be empty)
+ * @param type Frame type
+ * @param hdr First payload segment
+ * @param hdr_len Length of hdr
+ * @param data Second payload segment
+ * @param data_len Length of data; hdr_len + data_len <= TM_MAX_PAYLOAD
+ * @return 0 on success, -1 if the payload is too long
+ */
+int8_t telemetry_send(uint8_t type, const void* hdr, uint8_t hdr_len,
+                      const void* data, uint8_t data_len);
+
+/**
+ * Stream a memory region as a run of TM_TYPE_BUFFER frames
+ * @param partition Partition id (TM_PART_*)
+ * @param base Start of the region
+ * @param len Region length in bytes
+ */
+void telemetry_send_buffer(uint8_t partition, const uint8_t* base, uint16_t len);
+
+/**
+ * Send a TM_TYPE_STATS frame: tx pending (u8), tx high-water (u8),
+ * tx stalls (u16), rx dropped (u16), rx errors (u16), frames sent (u16)
+ */
+void telemetry_send_stats(void);
+
+#endif /* TELEMETRY_H */
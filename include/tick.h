@@ -0,0 +1,70 @@
+#ifndef TICK_H
+#define TICK_H
+
+#include <stdint.h>
+
+/*
+ * Millisecond system tick.
+ *
+ * Timer0 runs in CTC mode at clk/64 and its compare interrupt counts
+ * milliseconds (~40 cycles per tick, 0.25 % of the CPU at 16 MHz).
+ * millis() reads the counter atomically; micros() adds the elapsed part
+ * of the current millisecond from TCNT0 (4 us resolution at 16 MHz) and
+ * accounts for a compare match whose interrupt has not run yet. millis()
+ * wraps after ~49.7 days and micros() after ~71.6 minutes. Compare times
+ * by subtraction, as every() does, so a wrap does no harm.
+ *
+ * every() paces a fixed-rate activity without drift. It keeps a deadline,
+ * and each time the deadline passes it advances by exactly one period, so
+ * the time the activity itself takes does not add up:
+ *
+ *     tick_every_t status;
+ *     tick_every_start(&status);
+ *     while (1) {
+ *         if (every(&status, 1000)) {
+ *             ...                          // once per second, on the dot
+ *         }
+ *         ...                              // everything else, every pass
+ *     }
+ */
+
+#define TICK_PRESCALE 64
+#define TICK_OCR (F_CPU / TICK_PRESCALE / 1000 - 1)
+#define TICK_US_PER_COUNT (TICK_PRESCALE * 1000000UL / F_CPU)
+
+typedef struct {
+    uint32_t next;              // next deadline, millis()
+    uint16_t missed;            // deadlines skipped after a stall
+} tick_every_t;
+
+/**
+ * Start the tick. Replaces any other Timer0 setup.
+ */
+void tick_init(void);
+
+/**
+ * Milliseconds since tick_init() (any context)
+ */
+uint32_t millis(void);
+
+/**
+ * Microseconds since tick_init() (any context)
+ */
+uint32_t micros(void);
+
+/**
+ * Arm a periodic deadline; the first every() call on it fires at once
+ */
+void tick_every_start(tick_every_t* e);
+
+/**
+ * Check a periodic deadline
+ * @param e Deadline from tick_every_start()
+ * @param period_ms Period in milliseconds
+ * @return 1 when the deadline has passed (and moved one period on), else 0.
+ *         After a stall of more than one period, the missed deadlines are
+ *         skipped and counted in e->missed. The phase is kept.
+ */
+uint8_t every(tick_every_t* e, uint16_t period_ms);
+
+#endif /* TICK_H */
@@ -0,0 +1,122 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/wdt.h>
+#include <util/atomic.h>
+
+/*
+ * Crash-surviving event trace.
+ *
+ * A ring of 4-byte records lives in .noinit, so it survives watchdog,
+ * brown-out and external resets (everything but a power cycle). trace()
+ * is a few stores under a short cli/sei; it does not maintain the CRC.
+ * trace_seal() computes it instead, and only when records were added
+ * since the last seal. The main loop seals on every pass, and the
+ * watchdog interrupt seals just before a watchdog reset.
+ * Any record written after the last seal clears the sealed flag, so on the
+ * next boot the ring is one of:
+ *
+ *     TRACE_SEALED    magic and CRC match
+ *     TRACE_UNSEALED  magic matches, records written after the last seal
+ *                     (shown, but unverified)
+ *     TRACE_INVALID   power-on garbage or corrupted (e.g. stack overrun)
+ *
+ * An .init3 hook (src/trace_init.S) saves the reset cause (MCUSR, or r2 from Optiboot, which
+ * clears MCUSR itself) and stops a watchdog left running by a watchdog
+ * reset. Once the UART is up, trace_boot() streams the surviving ring and
+ * starts a new one.
+ */
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 16      // records, power of two <= 128
+#endif
+
+#define TRACE_MAGIC 0x7EAC
+
+// Ring states reported by trace_boot()
+#define TRACE_INVALID  0
+#define TRACE_SEALED   1
+#define TRACE_UNSEALED 2
+
+// Event ids
+#define TRACE_EV_BOOT  0x01     // arg8 = reset cause (MCUSR bits)
+#define TRACE_EV_WDT   0x02     // watchdog interrupt, reset follows
+#define TRACE_EV_CMD   0x03     // arg8 = first command character, arg16 = length
+#define TRACE_EV_BAUD  0x04     // arg16 = new rate / 100
+#define TRACE_EV_ALLOC 0x05     // arg8 = 0 pool / 1 arena, arg16 = failed size
+#define TRACE_EV_FREE  0x06     // arg16 = pointer pool_free() rejected
+
+typedef struct {
+    uint8_t id;
+    uint8_t arg8;
+    uint16_t arg16;
+} trace_rec_t;
+
+typedef struct {
+    uint16_t magic;
+    uint8_t head;               // next slot to write
+    uint8_t count;              // valid records, <= TRACE_RING_SIZE
+    uint8_t sealed;             // crc covers the current contents
+    uint8_t boots;              // resets this ring has survived
+    uint16_t crc;               // CRC-16 of everything above and rec[]
+    trace_rec_t rec[TRACE_RING_SIZE];
+} trace_ring_t;
+
+extern trace_ring_t trace_ring;
+
+// Reset cause captured before main (MCUSR bits: PORF, EXTRF, BORF, WDRF)
+extern uint8_t trace_reset_cause;
+
+/**
+ * Append one record (any context)
+ */
+static inline void trace(uint8_t id, uint8_t arg8, uint16_t arg16)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        trace_rec_t* r = &trace_ring.rec[trace_ring.head];
+        r->id = id;
+        r->arg8 = arg8;
+        r->arg16 = arg16;
+        trace_ring.head = (trace_ring.head + 1) & (TRACE_RING_SIZE - 1);
+        if (trace_ring.count < TRACE_RING_SIZE) {
+            trace_ring.count++;
+        }
+        trace_ring.sealed = 0;
+    }
+}
+
+/**
+ * Recompute the CRC so the current contents verify after a reset
+ */
+void trace_seal(void);
+
+/**
+ * Report the reset cause and the ring that survived it over UART
+ * (text lines, or a TM_TYPE_TRACE frame with TELEMETRY_BINARY), then start
+ * a fresh ring with a TRACE_EV_BOOT record. Call once after uart_init().
+ * @return Ring state found (TRACE_INVALID/SEALED/UNSEALED)
+ */
+uint8_t trace_boot(void);
+
+/**
+ * Arm the watchdog in interrupt+reset mode: the first timeout seals the
+ * ring and records TRACE_EV_WDT, the second resets the MCU
+ * @param timeout WDTO_* constant from <avr/wdt.h>
+ */
+void trace_watchdog_enable(uint8_t timeout);
+
+/**
+ * Reset the watchdog and re-arm its interrupt, which the hardware clears
+ * when it fires. Use in place of wdt_reset() so that every stall, not just
+ * the first one, seals the ring before the reset.
+ */
+static inline void trace_watchdog_kick(void)
+{
+    wdt_reset();
+    // WDIF is write-one-to-clear: keep a pending interrupt pending
+    WDTCSR = (WDTCSR & ~_BV(WDIF)) | _BV(WDIE);
+}
+
+#endif /* TRACE_H */
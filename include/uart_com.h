@@ -1,18 +1,116 @@
 #ifndef UART_COM_H
 #define UART_COM_H
 
+#ifndef F_CPU
 #define F_CPU 16000000UL
-#define BAUD 9600
-#define MYUBRR F_CPU/16/BAUD-1
+#endif
+
+// Rate used by uart_init() at boot; change later with uart_set_baud()
+#ifndef UART_BOOT_BAUD
+#define UART_BOOT_BAUD 9600UL
+#endif
 
 #include <avr/io.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Transmit ring size in bytes. Must be a power of two no larger than 256
+ * (indices are 8-bit). The ring lives in the .buffer_640 partition, so the
+ * application part of that partition shrinks by the same amount.
+ */
+#ifndef UART_TX_RING_SIZE
+#define UART_TX_RING_SIZE 256
+#endif
+
+/*
+ * Receive ring size in bytes. Must be a power of two no larger than 128.
+ * The ring lives in the .buffer_128 partition.
+ */
+#ifndef UART_RX_RING_SIZE
+#define UART_RX_RING_SIZE 64
+#endif
+
+/*
+ * Line/packet assembler state for uart_readline(). Bytes are accumulated
+ * into buf until the delimiter arrives ('\n' for text lines, 0x00 for
+ * COBS-style frames). Initialize with uart_line_init().
+ */
+typedef struct {
+    char* buf;
+    uint8_t size;
+    uint8_t len;
+    char delim;
+    uint8_t overflow;
+} uart_line_t;
+
+/*
+ * Baud-rate generator setting chosen by uart_calc_baud(). error is the
+ * deviation of the real rate from the requested one in 0.01 % units
+ * (e.g. 217 = +2.17 %); keep it within about +/-200 for reliable links.
+ * Rates the generator cannot reach (UBRR 0..4095, clk/16 or clk/8) report
+ * UART_BAUD_INVALID.
+ */
+#define UART_BAUD_MIN (F_CPU / (16UL * 4096))  // 244 at 16 MHz
+#define UART_BAUD_MAX (F_CPU / 8)              // 2 Mbit/s at 16 MHz
+#define UART_BAUD_INVALID INT16_MIN
+
+typedef struct {
+    uint16_t ubrr;
+    uint8_t u2x;
+    int16_t error;
+} uart_baud_t;
 
 /**
  * Initialize UART with given baud rate
- * @param ubrr Baud rate setting
+ * @param baud Baud rate in bits per second
+ */
+void uart_init(uint32_t baud);
+
+/**
+ * Compute the UBRR0/U2X0 pair that best approximates a baud rate.
+ * Both normal (clk/16) and double-speed (clk/8) modes are evaluated and
+ * the one with the lower absolute error wins; ties keep normal mode for
+ * its wider receiver tolerance.
+ * @param baud Requested baud rate in bits per second
+ * @param out Selected setting and its error; error is UART_BAUD_INVALID
+ *            (and the setting meaningless) outside UART_BAUD_MIN..MAX
+ */
+void uart_calc_baud(uint32_t baud, uart_baud_t* out);
+
+/**
+ * Switch baud rate at runtime. Pending TX bytes are sent at the old rate
+ * before the generator is reprogrammed.
+ * @param baud Requested baud rate in bits per second
+ * @return Rate error in 0.01 % units, or UART_BAUD_INVALID (nothing
+ *         changed) for 0 and other rates outside UART_BAUD_MIN..MAX
+ */
+int16_t uart_set_baud(uint32_t baud);
+
+/**
+ * Actual baud rate produced by the current generator setting
+ */
+uint32_t uart_get_baud(void);
+
+/**
+ * Queue raw bytes for interrupt-driven transmission.
+ * Returns as soon as every byte is in the TX ring; only blocks while the
+ * ring is full. With global interrupts disabled it drains the ring by polling.
+ * @param data Pointer to bytes to send
+ * @param len Number of bytes
  */
-void uart_init(unsigned int ubrr);
+void uart_write(const void* data, uint16_t len);
+
+/**
+ * Queue a single byte for transmission (same blocking rules as uart_write)
+ * @param c Byte to send
+ */
+void uart_putc(char c);
 
 /**
  * Print a null-terminated string via UART
@@ -21,11 +119,153 @@ void uart_init(unsigned int ubrr);
 void uart_print(const char* str);
 
 /**
- * Formatted print function via UART
+ * Print a null-terminated string stored in flash (PROGMEM / PSTR)
+ * @param str Flash address of the string
+ */
+void uart_print_P(const char* str);
+
+/**
+ * Block until the TX ring is empty and the last byte has left the shifter
+ */
+void uart_flush(void);
+
+/**
+ * Number of bytes currently waiting in the TX ring
+ */
+uint8_t uart_tx_pending(void);
+
+/**
+ * Highest TX ring occupancy seen since the last uart_tx_stats_reset()
+ */
+uint8_t uart_tx_high_water(void);
+
+/**
+ * Number of times a writer found the TX ring full and had to wait
+ */
+uint16_t uart_tx_stalls(void);
+
+/**
+ * Reset the TX high-water and stall counters
+ */
+void uart_tx_stats_reset(void);
+
+/**
+ * Pop one received byte without blocking
+ * @return Byte value (0-255), or -1 if the RX ring is empty
+ */
+int uart_getc(void);
+
+/**
+ * Copy up to max received bytes without blocking
+ * @param buf Destination
+ * @param max Capacity of buf
+ * @return Number of bytes copied (0 if nothing was pending)
+ */
+uint8_t uart_read(uint8_t* buf, uint8_t max);
+
+/**
+ * Number of bytes waiting in the RX ring
+ */
+uint8_t uart_rx_available(void);
+
+/**
+ * Number of bytes dropped because the RX ring was full
+ */
+uint16_t uart_rx_dropped(void);
+
+/**
+ * Number of bytes received with a framing, overrun or parity error
+ */
+uint16_t uart_rx_errors(void);
+
+/**
+ * Prepare a line/packet assembler
+ * @param line Assembler state
+ * @param buf Storage for one record (terminated with '\0' on completion)
+ * @param size Capacity of buf, including the terminator
+ * @param delim Record delimiter ('\n' for lines, 0x00 for framed packets)
+ */
+void uart_line_init(uart_line_t* line, char* buf, uint8_t size, char delim);
+
+/**
+ * Feed pending RX bytes into the assembler without blocking.
+ * For '\n'-delimited lines a trailing '\r' is stripped.
+ * @param line Assembler state
+ * @return Record length when a record is complete, 0 if more bytes are
+ *         needed, -1 if a record overflowed buf and was discarded
+ */
+int uart_readline(uart_line_t* line);
+
+/*
+ * Byte sink for the streaming formatter. Each converted character is
+ * handed to the sink as soon as it is produced; nothing is buffered.
+ */
+typedef void (*uprintf_sink_t)(void* ctx, char c);
+
+/**
+ * Streaming formatter core: %d %i %u %x %X %s %S %c %p %%
+ * plus %ld %li %lu %lx %lX for 32-bit long arguments.
+ * %S takes a string that lives in flash (PROGMEM / PSTR).
+ * Uses O(1) stack and has no output length limit.
+ * @param sink Byte sink
+ * @param ctx Opaque pointer passed to the sink
+ * @param format Format string
+ * @param args Argument list
+ * @return Number of characters emitted
+ */
+int uvfprintf(uprintf_sink_t sink, void* ctx, const char* format, va_list args);
+
+/**
+ * Same as uvfprintf() but the format string is read from flash with LPM
+ * @param sink Byte sink
+ * @param ctx Opaque pointer passed to the sink
+ * @param format Flash address of the format string
+ * @param args Argument list
+ * @return Number of characters emitted
+ */
+int uvfprintf_P(uprintf_sink_t sink, void* ctx, const char* format, va_list args);
+
+/**
+ * Formatted print to an arbitrary byte sink
+ * @param sink Byte sink
+ * @param ctx Opaque pointer passed to the sink
+ * @param format Format string
+ * @param ... Additional arguments
+ * @return Number of characters emitted
+ */
+int ufprintf(uprintf_sink_t sink, void* ctx, const char* format, ...);
+
+/**
+ * Formatted print function via UART, streamed straight into the TX ring
  * @param format Format string
  * @param ... Additional arguments
  * @return Number of characters printed
  */
 int uprintf(const char* format, ...);
 
-#endif /* UART_COM_H */
\ No newline at end of file
+/**
+ * Formatted print via UART with the format string kept in flash, so it
+ * never takes SRAM: uprintf_P(PSTR("x=%u\r\n"), x). A __flash string can
+ * be passed with a cast to (const char*).
+ * @param format Flash address of the format string
+ * @param ... Additional arguments
+ * @return Number of characters printed
+ */
+int uprintf_P(const char* format, ...);
+
+/**
+ * Formatted print into a memory buffer. Output is truncated to size-1
+ * characters and always terminated when size > 0.
+ * @param buf Destination
+ * @param size Capacity of buf
+ * @param format Format string
+ * @param ... Additional arguments
+ * @return Number of characters the full output has (may exceed size-1)
+ */
+int usnprintf(char* buf, size_t size, const char* format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_COM_H */
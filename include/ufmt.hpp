@@ -0,0 +1,287 @@
+#ifndef UFMT_HPP
+#define UFMT_HPP
+
+/*
+ * Compile-time parsed, type-checked replacement for uprintf (C++17).
+ *
+ *     UFMT("sig=%X %X %X n=%lu name=%s\r\n", sig[0], sig[1], sig[2], n, name);
+ *
+ * The format string is parsed entirely by the compiler. Each call site
+ * expands to a straight sequence of "emit literal" (uart_putc for single
+ * characters, uart_print_P from a flash array otherwise) and "emit typed
+ * value" (fmt_num kernels) calls; nothing interprets the format at run
+ * time and the format string itself never reaches SRAM.
+ *
+ * Conversions and the argument types they accept:
+ *
+ *     %d %i      signed integer up to int, or unsigned narrower than int
+ *     %u %x %X   unsigned integer up to unsigned int
+ *     %ld %li    signed integer up to long, or unsigned narrower than long
+ *     %lu %lx %lX unsigned integer up to unsigned long
+ *     %c         char
+ *     %s         char* / const char*, or a char array
+ *     %S         ufmt::P(flash_ptr)
+ *     %p         any pointer or array
+ *     %%         literal '%'
+ *
+ * Anything else - an integer for %p, a pointer for %u, a long for %d, a
+ * missing or extra argument - is a compile error.
+ *
+ * Build with -std=gnu++17 -fno-exceptions -fno-rtti. Output goes to the
+ * UART TX ring only; use uprintf()/ufprintf() for other sinks.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include "uart_com.h"
+#include "fmt_num.h"
+
+namespace ufmt {
+
+// Wrapper marking a string that lives in flash, for %S
+struct flash_str {
+    const char* ptr;
+};
+
+inline constexpr flash_str P(const char* ptr)
+{
+    return flash_str{ ptr };
+}
+
+namespace detail {
+
+// Minimal type traits (avr-libc ships no C++ standard library)
+template <typename T> struct strip { using type = T; };
+template <typename T> struct strip<const T> { using type = typename strip<T>::type; };
+template <typename T> struct strip<volatile T> { using type = typename strip<T>::type; };
+template <typename T> struct strip<T&> { using type = typename strip<T>::type; };
+template <typename T> struct strip<T&&> { using type = typename strip<T>::type; };
+// Arguments bind by reference, so arrays arrive undecayed: treat them as
+// the pointer they decay to (char[N] and const char[N] -> const char*)
+template <typename T, size_t N> struct strip<T[N]> { using type = const T*; };
+template <typename T, size_t N> struct strip<const T[N]> { using type = const T*; };
+
+template <typename T> struct int_kind { static constexpr int value = 0; };   // 0: not an integer
+template <> struct int_kind<signed char> { static constexpr int value = -1; };
+template <> struct int_kind<short> { static constexpr int value = -1; };
+template <> struct int_kind<int> { static constexpr int value = -1; };
+template <> struct int_kind<long> { static constexpr int value = -1; };
+template <> struct int_kind<long long> { static constexpr int value = -1; };
+template <> struct int_kind<unsigned char> { static constexpr int value = 1; };
+template <> struct int_kind<unsigned short> { static constexpr int value = 1; };
+template <> struct int_kind<unsigned int> { static constexpr int value = 1; };
+template <> struct int_kind<unsigned long> { static constexpr int value = 1; };
+template <> struct int_kind<unsigned long long> { static constexpr int value = 1; };
+
+template <typename T> struct is_pointer { static constexpr bool value = false; };
+template <typename T> struct is_pointer<T*> { static constexpr bool value = true; };
+
+template <typename T> struct is_cstring { static constexpr bool value = false; };
+template <> struct is_cstring<char*> { static constexpr bool value = true; };
+template <> struct is_cstring<const char*> { static constexpr bool value = true; };
+
+template <typename A, typename B> struct same { static constexpr bool value = false; };
+template <typename A> struct same<A, A> { static constexpr bool value = true; };
+
+enum class conv : uint8_t { end, invalid, percent, d, u, x, X, ld, lu, lx, lX, c, s, S, p };
+
+struct spec {
+    conv kind;
+    size_t next;    // index just past the conversion
+};
+
+// Index of the next '%' (or the terminator) at or after pos
+constexpr size_t find_conv(const char* s, size_t pos)
+{
+    while (s[pos] != '\0' && s[pos] != '%') {
+        pos++;
+    }
+    return pos;
+}
+
+// Decode the conversion that starts at the '%' at pos
+constexpr spec parse(const char* s, size_t pos)
+{
+    if (s[pos] == '\0') {
+        return spec{ conv::end, pos };
+    }
+    char ch = s[pos + 1];
+    if (ch == 'l') {
+        switch (s[pos + 2]) {
+        case 'd': case 'i': return spec{ conv::ld, pos + 3 };
+        case 'u': return spec{ conv::lu, pos + 3 };
+        case 'x': return spec{ conv::lx, pos + 3 };
+        case 'X': return spec{ conv::lX, pos + 3 };
+        default: return spec{ conv::invalid, pos + 2 };
+        }
+    }
+    switch (ch) {
+    case '%': return spec{ conv::percent, pos + 2 };
+    case 'd': case 'i': return spec{ conv::d, pos + 2 };
+    case 'u': return spec{ conv::u, pos + 2 };
+    case 'x': return spec{ conv::x, pos + 2 };
+    case 'X': return spec{ conv::X, pos + 2 };
+    case 'c': return spec{ conv::c, pos + 2 };
+    case 's': return spec{ conv::s, pos + 2 };
+    case 'S': return spec{ conv::S, pos + 2 };
+    case 'p': return spec{ conv::p, pos + 2 };
+    default: return spec{ conv::invalid, pos + 1 };
+    }
+}
+
+template <typename T>
+constexpr bool accepts(conv k)
+{
+    constexpr int kind = int_kind<T>::value;
+    switch (k) {
+    case conv::d:
+        return (kind < 0 && sizeof(T) <= sizeof(int)) || (kind > 0 && sizeof(T) < sizeof(int));
+    case conv::u: case conv::x: case conv::X:
+        return kind > 0 && sizeof(T) <= sizeof(unsigned int);
+    case conv::ld:
+        return (kind < 0 && sizeof(T) <= sizeof(long)) || (kind > 0 && sizeof(T) < sizeof(long));
+    case conv::lu: case conv::lx: case conv::lX:
+        return kind > 0 && sizeof(T) <= sizeof(unsigned long);
+    case conv::c:
+        return same<T, char>::value;
+    case conv::s:
+        return is_cstring<T>::value;
+    case conv::S:
+        return same<T, flash_str>::value;
+    case conv::p:
+        return is_pointer<T>::value;
+    default:
+        return false;
+    }
+}
+
+// Literal text [B, B + sizeof...(I)) of the format, stored in flash
+template <typename S, size_t B, size_t... I>
+struct segment {
+    static const char data[sizeof...(I) + 1];
+};
+
+template <typename S, size_t B, size_t... I>
+const char segment<S, B, I...>::data[sizeof...(I) + 1] PROGMEM = { S::str()[B + I]..., '\0' };
+
+// Build segment<S, B, 0, 1, ..., N-1>
+template <typename S, size_t B, size_t N, size_t... I>
+struct make_segment {
+    using type = typename make_segment<S, B, N - 1, N - 1, I...>::type;
+};
+
+template <typename S, size_t B, size_t... I>
+struct make_segment<S, B, 0, I...> {
+    using type = segment<S, B, I...>;
+};
+
+template <typename S, size_t B, size_t E>
+inline void emit_literal()
+{
+    if constexpr (E - B == 1) {
+        // Bound first: as a plain call argument, S::str() would be a run-time
+        // call at -O0 and put the whole format in .rodata
+        constexpr char ch = S::str()[B];
+        uart_putc(ch);
+    } else if constexpr (E > B) {
+        uart_print_P(make_segment<S, B, E - B>::type::data);
+    }
+}
+
+inline void emit_digits(const char* buf, uint8_t n)
+{
+    uart_write(buf, n);
+}
+
+template <conv K, typename T>
+inline void emit_value(T v)
+{
+    char buf[FMT_NUM_MAX_DIGITS];
+
+    if constexpr (K == conv::d) {
+        emit_digits(buf, fmt_int(buf, (int)v));
+    } else if constexpr (K == conv::u) {
+        emit_digits(buf, fmt_uint(buf, (unsigned int)v));
+    } else if constexpr (K == conv::x || K == conv::X || K == conv::lx || K == conv::lX) {
+        emit_digits(buf, fmt_hex32(buf, (uint32_t)v, K == conv::X || K == conv::lX));
+    } else if constexpr (K == conv::ld) {
+        emit_digits(buf, fmt_i32(buf, (int32_t)v));
+    } else if constexpr (K == conv::lu) {
+        emit_digits(buf, fmt_u32(buf, (uint32_t)v));
+    } else if constexpr (K == conv::c) {
+        uart_putc(v);
+    } else if constexpr (K == conv::s) {
+        uart_print(v);
+    } else if constexpr (K == conv::S) {
+        uart_print_P(v.ptr);
+    } else if constexpr (K == conv::p) {
+        // Same layout as uprintf: 0x + 6 hex digits
+        unsigned long addr = (unsigned long)(uintptr_t)v;
+        buf[0] = '0';
+        buf[1] = 'x';
+        for (uint8_t i = 0; i < 6; i++) {
+            uint8_t nibble = (addr >> ((5 - i) * 4)) & 0xF;
+            buf[2 + i] = nibble < 10 ? '0' + nibble : 'a' - 10 + nibble;
+        }
+        emit_digits(buf, 8);
+    }
+}
+
+// No arguments left: the rest of the format may only contain literals and %%
+template <typename S, size_t Pos>
+inline void step()
+{
+    constexpr size_t pct = find_conv(S::str(), Pos);
+    emit_literal<S, Pos, pct>();
+    // Scalars, not a constexpr spec: at -O0 an aggregate local is emitted
+    // to .rodata
+    constexpr conv kind = parse(S::str(), pct).kind;
+    constexpr size_t next = parse(S::str(), pct).next;
+    static_assert(kind == conv::end || kind == conv::percent,
+                  "UFMT: format has more conversions than arguments");
+    if constexpr (kind == conv::percent) {
+        uart_putc('%');
+        step<S, next>();
+    }
+}
+
+template <typename S, size_t Pos, typename T, typename... Rest>
+inline void step(const T& value, const Rest&... rest)
+{
+    constexpr size_t pct = find_conv(S::str(), Pos);
+    emit_literal<S, Pos, pct>();
+    constexpr conv kind = parse(S::str(), pct).kind;
+    constexpr size_t next = parse(S::str(), pct).next;
+    static_assert(kind != conv::end, "UFMT: more arguments than conversions");
+    static_assert(kind != conv::invalid, "UFMT: unsupported conversion");
+    if constexpr (kind == conv::percent) {
+        uart_putc('%');
+        step<S, next>(value, rest...);
+    } else if constexpr (kind != conv::end && kind != conv::invalid) {
+        using U = typename strip<T>::type;
+        static_assert(accepts<U>(kind), "UFMT: argument type does not match conversion");
+        emit_value<kind, U>(value);
+        step<S, next>(rest...);
+    }
+}
+
+} // namespace detail
+
+template <typename S, typename... Args>
+inline void print(const Args&... args)
+{
+    detail::step<S, 0>(args...);
+}
+
+} // namespace ufmt
+
+// The format must be a string literal; it only exists at compile time
+#define UFMT(fmt, ...) do {                                             \
+        struct ufmt_fmt_ {                                              \
+            static constexpr const char* str() { return fmt; }          \
+        };                                                              \
+        ufmt::print<ufmt_fmt_>(__VA_ARGS__);                            \
+    } while (0)
+
+#endif /* UFMT_HPP */
@@ -0,0 +1,123 @@
+#ifndef ULOG_H
+#define ULOG_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "uart_com.h"
+
+/*
+ * Deferred binary logging (defmt/Trice style).
+ *
+ * ULOG("x=%u y=%ld\r\n", x, y) has two modes:
+ *
+ * - Default: plain text, identical to uprintf_P(PSTR(fmt), ...).
+ * - ULOG_DEFERRED: the format string never reaches the MCU. Each call site
+ *   stores a descriptor in the non-loaded .ulog_fmt ELF section and the
+ *   firmware only sends a record
+ *
+ *       [id lo][id hi][arg bytes...][crc16 lo][crc16 hi]
+ *
+ *   where id is the descriptor offset inside .ulog_fmt and the CRC
+ *   (crc16.h) covers id and arguments. The record is COBS-encoded
+ *   (telemetry_cobs_send()) and sent between two 0x00 delimiters, so plain
+ *   uprintf() text on the same UART falls between records and the decoder
+ *   can resynchronise on any delimiter. Integer and pointer arguments go
+ *   out as their raw little-endian bytes; char* arguments (and char
+ *   arrays, string literals) as a length byte followed by the characters
+ *   (max 255). `make ULOG=deferred` extracts the descriptor table and checks
+ *   every format against its arguments; scripts/ulog_decode.py turns the
+ *   byte stream back into text.
+ *
+ * Descriptor layout: argument kinds ('1', '2', '4', '8' = byte size,
+ * 's' = string) terminated by '\0', then the format string and its '\0'.
+ *
+ * Up to ULOG_MAX_ARGS arguments per call: integers, void* (cast other
+ * pointers) and char* / char arrays. Any other argument type is a compile
+ * error. %S has no deferred form (the flash string would have to be sent);
+ * the table check in the build rejects it, like a conversion whose
+ * argument kind does not match. Records are not interleaving-safe: log
+ * from the main context only.
+ */
+
+#define ULOG_MAX_ARGS 8
+
+#ifdef ULOG_DEFERRED
+
+typedef struct {
+    const void* value;          // the argument's value (for 's', the char*)
+    char kind;
+} ulog_arg_t;
+
+// (void)0, x: arrays decay to pointers, integers keep their own type
+#define ULOG_DECAY(x) ((void)0, (x))
+
+// Argument kind for the descriptor; 0 for a type ULOG cannot send
+#define ULOG_KIND(x) _Generic(ULOG_DECAY(x),                                \
+        _Bool: '1', char: '1', signed char: '1', unsigned char: '1',         \
+        short: (char)('0' + sizeof(short)),                                  \
+        unsigned short: (char)('0' + sizeof(short)),                         \
+        int: (char)('0' + sizeof(int)),                                      \
+        unsigned int: (char)('0' + sizeof(int)),                             \
+        long: (char)('0' + sizeof(long)),                                    \
+        unsigned long: (char)('0' + sizeof(long)),                           \
+        long long: (char)('0' + sizeof(long long)),                          \
+        unsigned long long: (char)('0' + sizeof(long long)),                 \
+        void*: (char)('0' + sizeof(void*)),                                  \
+        const void*: (char)('0' + sizeof(void*)),                            \
+        volatile void*: (char)('0' + sizeof(void*)),                         \
+        const volatile void*: (char)('0' + sizeof(void*)),                   \
+        char*: 's',                                                          \
+        const char*: 's',                                                    \
+        default: 0)
+
+#define ULOG_CHECK(x) _Static_assert(ULOG_KIND(x) != 0,                      \
+        "ULOG: arguments must be integers, void* or char* (cast other pointers)");
+#define ULOG_KIND_ITEM(x) ULOG_KIND(x),
+#define ULOG_ARG_ITEM(x) { (const __typeof__(ULOG_DECAY(x))[]){ (x) }, ULOG_KIND(x) },
+
+#define ULOG(fmt, ...) do {                                                 \
+        ULOG_EACH(ULOG_CHECK, ##__VA_ARGS__)                                \
+        static const struct {                                               \
+            char kinds[ULOG_NARG(__VA_ARGS__) + 1];                         \
+            char format[sizeof(fmt)];                                       \
+        } ulog_site_                                                        \
+            __attribute__((section(".ulog_fmt"), used, aligned(1))) =       \
+            { { ULOG_EACH(ULOG_KIND_ITEM, ##__VA_ARGS__) '\0' }, fmt };      \
+        const ulog_arg_t ulog_args_[] = {                                   \
+            ULOG_EACH(ULOG_ARG_ITEM, ##__VA_ARGS__) { 0, 0 }                \
+        };                                                                  \
+        ulog_send((uint16_t)(uintptr_t)&ulog_site_, ulog_args_,             \
+                  ULOG_NARG(__VA_ARGS__));                                  \
+    } while (0)
+
+/**
+ * Send one framed deferred record
+ * @param id Descriptor offset in .ulog_fmt
+ * @param args Arguments in format order
+ * @param count Number of arguments, <= ULOG_MAX_ARGS
+ */
+void ulog_send(uint16_t id, const ulog_arg_t* args, uint8_t count);
+
+#else
+
+#define ULOG(fmt, ...) uprintf_P(PSTR(fmt), ##__VA_ARGS__)
+
+#endif /* ULOG_DEFERRED */
+
+// Argument counting / iteration helpers (0-8 arguments)
+#define ULOG_NARG(...) ULOG_NARG_(_0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define ULOG_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define ULOG_CAT(a, b) ULOG_CAT_(a, b)
+#define ULOG_CAT_(a, b) a##b
+#define ULOG_EACH(m, ...) ULOG_CAT(ULOG_EACH_, ULOG_NARG(__VA_ARGS__))(m, ##__VA_ARGS__)
+#define ULOG_EACH_0(m)
+#define ULOG_EACH_1(m, a) m(a)
+#define ULOG_EACH_2(m, a, ...) m(a) ULOG_EACH_1(m, __VA_ARGS__)
+#define ULOG_EACH_3(m, a, ...) m(a) ULOG_EACH_2(m, __VA_ARGS__)
+#define ULOG_EACH_4(m, a, ...) m(a) ULOG_EACH_3(m, __VA_ARGS__)
+#define ULOG_EACH_5(m, a, ...) m(a) ULOG_EACH_4(m, __VA_ARGS__)
+#define ULOG_EACH_6(m, a, ...) m(a) ULOG_EACH_5(m, __VA_ARGS__)
+#define ULOG_EACH_7(m, a, ...) m(a) ULOG_EACH_6(m, __VA_ARGS__)
+#define ULOG_EACH_8(m, a, ...) m(a) ULOG_EACH_7(m, __VA_ARGS__)
+
+#endif /* ULOG_H */
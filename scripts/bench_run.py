@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Run benchmark firmware images in simavr and collect their cycle counts.
+
+Usage:
+    bench_run.py [--simavr PATH] [--mcu MCU] [--freq HZ] [--timeout S]
+                 [-o bench_results.json] IMAGE.elf...
+
+Each image prints `BENCH,<name>,<cycles>` lines over UART (bench/bench.h)
+and then sleeps with interrupts off, which ends the simulation. simavr
+echoes UART0 to stdout; those lines are parsed and written as JSON:
+
+    {"mcu": ..., "f_cpu": ..., "results": {"<image>": {"<name>": cycles}}}
+
+A cycle count of -1 means the measured region overflowed Timer1.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+BENCH_LINE = re.compile(r"BENCH,([^,\s]+),(-?\d+)")
+
+
+def run_image(simavr, mcu, freq, image, timeout):
+    cmd = [simavr, "-m", mcu, "-f", str(freq), image]
+    try:
+        proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                              timeout=timeout, check=False)
+        output = proc.stdout
+    except subprocess.TimeoutExpired as exc:
+        output = exc.stdout or b""
+        print("warning: %s timed out after %ss" % (image, timeout), file=sys.stderr)
+    results = {}
+    for match in BENCH_LINE.finditer(output.decode("latin-1")):
+        results[match.group(1)] = int(match.group(2))
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("images", nargs="+")
+    parser.add_argument("--simavr", default="simavr")
+    parser.add_argument("--mcu", default="atmega328p")
+    parser.add_argument("--freq", type=int, default=16000000)
+    parser.add_argument("--timeout", type=float, default=30)
+    parser.add_argument("-o", "--output", default="bench_results.json")
+    args = parser.parse_args()
+
+    report = {"mcu": args.mcu, "f_cpu": args.freq, "results": {}}
+    failed = False
+    for image in args.images:
+        name = os.path.splitext(os.path.basename(image))[0]
+        results = run_image(args.simavr, args.mcu, args.freq, image, args.timeout)
+        if not results:
+            print("error: %s produced no BENCH lines" % image, file=sys.stderr)
+            failed = True
+        report["results"][name] = results
+        for bench, cycles in results.items():
+            print("%-20s %-28s %8d" % (name, bench, cycles))
+
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+        f.write("\n")
+    print("wrote %s" % args.output)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
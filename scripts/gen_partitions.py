@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Generate the SRAM partition layout from linkers/partitions.cfg.
+
+Usage:
+    gen_partitions.py [--config linkers/partitions.cfg] [--ld-dir linkers]
+                      [--header include/partitions.h]
+
+Writes:
+    partitions_memory.ld    MEMORY lines, INCLUDEd by buffer_no_heap.ld
+    partitions_sections.ld  image + NOLOAD output sections and ASSERTs,
+                            INCLUDEd likewise
+    partitions.h            origins, sizes, the .data origin, the partition
+                            name list and sized extern declarations
+
+Each partition N exports __N_start, __N_free (first byte no input section
+claimed) and __N_end, and collects input sections named .N and .N.*.
+
+Input sections named .N.image / .N.image.* (PARTITION_IMAGE in startup.h)
+form an initial image at the start of the partition. Its contents are stored
+in flash (AT> text) and copied in at startup by src/partition_images.S, which
+reads __N_image_start, __N_image_end and __N_image_load.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+AVR_DATA_OFFSET = 0x800000
+BANNER = "Generated by scripts/gen_partitions.py from %s - do not edit"
+
+
+def parse(path):
+    sram = None
+    data_min = 0
+    parts = []
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            fields = line.split("#", 1)[0].split()
+            if not fields:
+                continue
+            try:
+                if fields[0] == "sram" and len(fields) == 3:
+                    sram = (int(fields[1], 0), int(fields[2], 0))
+                elif fields[0] == "data_min" and len(fields) == 2:
+                    data_min = int(fields[1], 0)
+                elif fields[0] == "partition" and len(fields) == 3:
+                    if not re.fullmatch(r"[A-Za-z_]\w*", fields[1]):
+                        raise ValueError("bad partition name '%s'" % fields[1])
+                    parts.append((fields[1], int(fields[2], 0)))
+                else:
+                    raise ValueError("unknown directive")
+            except ValueError as exc:
+                raise SystemExit("%s:%d: %s" % (path, lineno, exc))
+    if sram is None:
+        raise SystemExit("%s: missing 'sram <origin> <bytes>'" % path)
+    names = [n for n, _ in parts]
+    if len(set(names)) != len(names) or "data" in names:
+        raise SystemExit("%s: partition names must be unique and not 'data'" % path)
+    return sram, data_min, parts
+
+
+def layout(sram, data_min, parts):
+    origin, total = sram
+    placed = []
+    addr = origin
+    for name, size in parts:
+        if size <= 0:
+            raise SystemExit("error: partition %s has size %d" % (name, size))
+        placed.append((name, addr, size))
+        addr += size
+    data = total - (addr - origin)
+    if data < data_min:
+        raise SystemExit("error: partitions leave %d bytes for data/stack, data_min is %d"
+                         % (data, data_min))
+    return placed, (addr, data)
+
+
+def write(path, text):
+    # Only touch the file when it changes, so make does not rebuild needlessly;
+    # the Makefile's stamp records that the generator ran
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def memory_ld(cfg, placed, data):
+    out = ["/* %s */\n" % (BANNER % cfg)]
+    for name, origin, size in placed:
+        out.append("%-11s (rw!x) : ORIGIN = 0x%06x, LENGTH = %d\n" % (name, origin, size))
+    out.append("%-11s (rw!x) : ORIGIN = 0x%06x, LENGTH = %d\n" % ("data", data[0], data[1]))
+    return "".join(out)
+
+
+def sections_ld(cfg, placed):
+    out = ["/* %s */\n" % (BANNER % cfg)]
+    for name, origin, size in placed:
+        out.append("""
+.{n}.image :
+{{
+  PROVIDE(__{n}_start = .);
+  PROVIDE(__{n}_image_start = .);
+  KEEP(*(.{n}.image))
+  KEEP(*(.{n}.image.*))
+  PROVIDE(__{n}_image_end = .);
+}} > {n} AT> text
+PROVIDE(__{n}_image_load = LOADADDR(.{n}.image));
+
+.{n} (NOLOAD) :
+{{
+  *(.{n})
+  *(.{n}.*)
+  PROVIDE(__{n}_free = .);
+  . = ORIGIN({n}) + LENGTH({n});
+  PROVIDE(__{n}_end = .);
+}} > {n}
+ASSERT(SIZEOF(.{n}.image) + SIZEOF(.{n}) <= {s}, "ERROR: .{n} exceeds {s} bytes")
+""".format(n=name, s=size))
+    return "".join(out)
+
+
+def header(cfg, sram, data_min, placed, data):
+    out = ["/* %s */\n" % (BANNER % cfg), "#ifndef PARTITIONS_H\n#define PARTITIONS_H\n\n"]
+    out.append("// Data-space addresses (as C pointers see them, without the 0x800000 offset)\n")
+    out.append("#define SRAM_ORIGIN 0x%04x\n" % (sram[0] - AVR_DATA_OFFSET))
+    out.append("#define SRAM_SIZE %d\n\n" % sram[1])
+    for name, origin, size in placed:
+        up = name.upper()
+        out.append("#define PARTITION_%s_ORIGIN 0x%04x\n" % (up, origin - AVR_DATA_OFFSET))
+        out.append("#define PARTITION_%s_SIZE %d\n" % (up, size))
+    out.append("\n// .data/.bss/.noinit and the stack\n")
+    out.append("#define PARTITION_DATA_ORIGIN 0x%04x\n" % (data[0] - AVR_DATA_OFFSET))
+    out.append("#define PARTITION_DATA_SIZE %d\n" % data[1])
+    out.append("#define PARTITION_DATA_MIN %d\n" % data_min)
+    out.append("\n// Every partition, in address order (for .irp in assembly)\n")
+    out.append("#define PARTITION_NAMES %s\n" % ", ".join(n for n, _, _ in placed))
+    out.append("\n#ifndef __ASSEMBLER__\n\n#include <stdint.h>\n\n")
+    out.append("// Linker-provided bounds (see partitions_sections.ld)\n")
+    for name, origin, size in placed:
+        out.append("extern uint8_t __%s_start[PARTITION_%s_SIZE];\n" % (name, name.upper()))
+        out.append("extern uint8_t __%s_free[];\n" % name)
+        out.append("extern uint8_t __%s_end[];\n" % name)
+    out.append("\n// Initial images (see partitions_sections.ld): SRAM bounds, flash copy\n")
+    for name, origin, size in placed:
+        out.append("extern uint8_t __%s_image_start[];\n" % name)
+        out.append("extern uint8_t __%s_image_end[];\n" % name)
+        out.append("extern const uint8_t __%s_image_load[];\n" % name)
+    out.append("\n#endif /* __ASSEMBLER__ */\n\n#endif /* PARTITIONS_H */\n")
+    return "".join(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("--config", default="linkers/partitions.cfg")
+    ap.add_argument("--ld-dir", default="linkers")
+    ap.add_argument("--header", default="include/partitions.h")
+    args = ap.parse_args()
+
+    sram, data_min, parts = parse(args.config)
+    placed, data = layout(sram, data_min, parts)
+    write(os.path.join(args.ld_dir, "partitions_memory.ld"), memory_ld(args.config, placed, data))
+    write(os.path.join(args.ld_dir, "partitions_sections.ld"), sections_ld(args.config, placed))
+    write(args.header, header(args.config, sram, data_min, placed, data))
+    for name, origin, size in placed:
+        print("%-12s 0x%06x %5d" % (name, origin, size))
+    print("%-12s 0x%06x %5d" % ("data", data[0], data[1]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
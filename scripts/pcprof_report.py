@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Flat profile from the PC-sampling profiler's PCPROF lines.
+
+Usage:
+    pcprof_report.py [--nm avr-nm | --map IMAGE.map] [--top N] IMAGE.elf [CAPTURE]
+    pcprof_report.py --simavr PATH [--mcu MCU] [--freq HZ] [--duration S] IMAGE.elf
+
+The firmware (make PCPROF=on) prints, per streaming period:
+
+    PCPROF,B,<bin bytes>,<sample rate>
+    PCPROF,S,<bin start address, hex>,<samples>
+    PCPROF,E,<samples outside the bins>
+
+CAPTURE is a UART capture file ("-" or nothing reads stdin). With
+--simavr the image runs headless in simavr for --duration seconds of wall
+time instead, and its UART output is the capture; this works without
+hardware and is what make pcprof-sim does.
+
+Every period is summed. A bin usually spans several functions, so its
+samples are split between them by the bytes of each function inside the
+bin. Function extents come from `avr-nm -n -S` (default), or from the
+symbol addresses in the link map (--map; sizes are taken as the distance
+to the next symbol).
+"""
+
+import argparse
+import collections
+import re
+import subprocess
+import sys
+
+PCPROF_LINE = re.compile(r"PCPROF,([BSE]),([0-9A-Fa-f]+)(?:,(\d+))?")
+MAP_SYMBOL = re.compile(r"^\s+0x([0-9a-f]+)\s+([A-Za-z_.$][\w.$]*)\s*$")
+FLASH_END = 0x800000            # addresses above are SRAM/EEPROM in avr-ld
+
+
+def read_samples(text):
+    bin_bytes = None
+    rate = None
+    bins = collections.Counter()
+    other = 0
+    periods = 0
+    for match in PCPROF_LINE.finditer(text):
+        kind, a, b = match.groups()
+        if kind == "B":
+            bin_bytes, rate = int(a), int(b)
+        elif kind == "S" and bin_bytes:
+            bins[int(a, 16)] += int(b)
+        elif kind == "E" and bin_bytes:
+            other += int(a)
+            periods += 1
+    return bin_bytes, rate, bins, other, periods
+
+
+def symbols_nm(nm, elf):
+    out = subprocess.run([nm, "-n", "-S", "--defined-only", elf],
+                         stdout=subprocess.PIPE, check=True)
+    syms = []
+    for line in out.stdout.decode("latin-1").splitlines():
+        fields = line.split()
+        if len(fields) == 4 and fields[2] in "TtWw":
+            addr, size = int(fields[0], 16), int(fields[1], 16)
+            if addr < FLASH_END and size:
+                syms.append((addr, size, fields[3]))
+    return syms
+
+
+def symbols_map(path):
+    addrs = {}
+    with open(path, encoding="latin-1") as f:
+        for line in f:
+            match = MAP_SYMBOL.match(line)
+            if match:
+                addr = int(match.group(1), 16)
+                if addr < FLASH_END:
+                    addrs.setdefault(addr, match.group(2))
+    ordered = sorted(addrs.items())
+    syms = []
+    for (addr, name), nxt in zip(ordered, ordered[1:] + [(None, None)]):
+        if nxt[0] is not None:
+            syms.append((addr, nxt[0] - addr, name))
+    return syms
+
+
+def attribute(bins, bin_bytes, syms):
+    per_func = collections.Counter()
+    for start, count in bins.items():
+        end = start + bin_bytes
+        overlaps = [(min(end, a + s) - max(start, a), name)
+                    for a, s, name in syms if a < end and a + s > start]
+        covered = sum(o for o, _ in overlaps)
+        if not covered:
+            per_func["<0x%04x>" % start] += count
+            continue
+        for o, name in overlaps:
+            per_func[name] += count * o / covered
+    return per_func
+
+
+def run_simavr(simavr, mcu, freq, elf, duration):
+    try:
+        proc = subprocess.run([simavr, "-m", mcu, "-f", str(freq), elf],
+                              stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                              timeout=duration, check=False)
+        output = proc.stdout
+    except subprocess.TimeoutExpired as exc:
+        output = exc.stdout or b""
+    return output.decode("latin-1")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf")
+    parser.add_argument("capture", nargs="?", default="-")
+    parser.add_argument("--nm", default="avr-nm")
+    parser.add_argument("--map", help="take symbols from this link map instead of avr-nm")
+    parser.add_argument("--top", type=int, default=25, help="functions to list (0: all)")
+    parser.add_argument("--simavr", help="run ELF in this simavr instead of reading a capture")
+    parser.add_argument("--mcu", default="atmega328p")
+    parser.add_argument("--freq", type=int, default=16000000)
+    parser.add_argument("--duration", type=float, default=30)
+    args = parser.parse_args()
+
+    if args.simavr:
+        text = run_simavr(args.simavr, args.mcu, args.freq, args.elf, args.duration)
+    elif args.capture == "-":
+        text = sys.stdin.buffer.read().decode("latin-1")
+    else:
+        with open(args.capture, "rb") as f:
+            text = f.read().decode("latin-1")
+
+    bin_bytes, rate, bins, other, periods = read_samples(text)
+    if not periods:
+        print("error: no complete PCPROF period in the input (built with PCPROF=on?)",
+              file=sys.stderr)
+        return 1
+    syms = symbols_map(args.map) if args.map else symbols_nm(args.nm, args.elf)
+    per_func = attribute(bins, bin_bytes, syms)
+    total = sum(bins.values()) + other
+
+    print("%d samples in %d periods, %d Hz, %d-byte bins, %d outside the bins"
+          % (total, periods, rate, bin_bytes, other))
+    print("%7s %9s  %s" % ("%", "samples", "function"))
+    ranked = per_func.most_common(args.top or None)
+    for name, count in ranked:
+        print("%6.2f%% %9.1f  %s" % (100.0 * count / total, count, name))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
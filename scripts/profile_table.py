@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Compare build profiles: flash, SRAM and cycle counts side by side.
+
+Usage:
+    profile_table.py [--size avr-size] [--key BENCH_NAME]...
+                     PROFILE=IMAGE.elf,RESULTS.json...
+
+For each profile, flash is what the image stores in program memory: .text,
+the .data load image, and the partitions' initial images (.N.image). SRAM
+is the data region used by .data, .bss and .noinit; the partitions are
+fixed-size and the same in every profile. Cycle columns come from the
+bench_results.json of that profile (scripts/bench_run.py), looked up in
+every image; a key no image reported prints as "-".
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+
+FLASH_SECTIONS = (".text", ".data")
+SRAM_SECTIONS = (".data", ".bss", ".noinit")
+
+
+def section_sizes(size_tool, elf):
+    out = subprocess.run([size_tool, "-A", elf], stdout=subprocess.PIPE, check=True)
+    sizes = {}
+    for line in out.stdout.decode("latin-1").splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith(".") and fields[1].isdigit():
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def cycles(results_path):
+    with open(results_path) as f:
+        report = json.load(f)
+    merged = {}
+    for image in sorted(report.get("results", {})):
+        for name, count in report["results"][image].items():
+            merged.setdefault(name, count)
+    return merged
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("profiles", nargs="+", metavar="PROFILE=IMAGE.elf,RESULTS.json")
+    parser.add_argument("--size", default="avr-size")
+    parser.add_argument("--key", action="append", default=[], metavar="BENCH_NAME",
+                        help="benchmark to show as a column (repeatable)")
+    args = parser.parse_args()
+
+    rows = []
+    for spec in args.profiles:
+        try:
+            name, paths = spec.split("=", 1)
+            elf, results = paths.split(",", 1)
+        except ValueError:
+            parser.error("expected PROFILE=IMAGE.elf,RESULTS.json, got '%s'" % spec)
+        sizes = section_sizes(args.size, elf)
+        flash = sum(sizes.get(s, 0) for s in FLASH_SECTIONS)
+        flash += sum(v for s, v in sizes.items() if s.endswith(".image"))
+        sram = sum(sizes.get(s, 0) for s in SRAM_SECTIONS)
+        counts = cycles(results)
+        rows.append([name, str(flash), str(sram)] + [str(counts.get(k, "-")) for k in args.key])
+
+    header = ["profile", "flash", "sram"] + args.key
+    widths = [max(len(r[i]) for r in rows + [header]) for i in range(len(header))]
+    for row in [header] + rows:
+        print("  ".join(cell.rjust(w) if i else cell.ljust(w)
+                        for i, (cell, w) in enumerate(zip(row, widths))))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Fail when an object file has .rodata that no allowed symbol accounts for.
+
+Usage:
+    rodata_check.py [--objdump PATH] [--allow PREFIX]... FILE.o...
+
+buffer_no_heap.ld groups .rodata with .data, so anything the compiler puts
+there is copied to SRAM at startup. Every .rodata* section must be fully
+covered by symbols whose demangled name starts with one of the --allow
+prefixes. Anything else, such as an anonymous string literal or a spilled
+constant, is reported with a hex dump and the script exits with status 1.
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+
+SECTION = re.compile(r"^\s*\d+\s+(\.rodata\S*)\s+([0-9a-fA-F]+)\s")
+SYMBOL = re.compile(r"^[0-9a-fA-F]+\s.{7}\s(\S+)\s+([0-9a-fA-F]+)\s+(.*)$")
+
+
+def objdump(tool, args, path):
+    out = subprocess.run([tool] + args + [path], stdout=subprocess.PIPE, check=True)
+    return out.stdout.decode("latin-1").splitlines()
+
+
+def check(tool, path, allow):
+    sizes = {}
+    for line in objdump(tool, ["-h"], path):
+        match = SECTION.match(line)
+        if match:
+            sizes[match.group(1)] = int(match.group(2), 16)
+    covered = dict.fromkeys(sizes, 0)
+    for line in objdump(tool, ["-t", "-C"], path):
+        match = SYMBOL.match(line)
+        if match and match.group(1) in covered and match.group(3).startswith(allow):
+            covered[match.group(1)] += int(match.group(2), 16)
+    bad = [name for name, size in sizes.items() if size > covered[name]]
+    for name in bad:
+        print("%s: %s holds %d bytes outside the allowed symbols"
+              % (path, name, sizes[name] - covered[name]), file=sys.stderr)
+        for line in objdump(tool, ["-s", "-j", name], path)[4:]:
+            print("    " + line, file=sys.stderr)
+    return not bad
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("objects", nargs="+")
+    parser.add_argument("--objdump", default="objdump")
+    parser.add_argument("--allow", action="append", default=[],
+                        help="demangled symbol prefix allowed in .rodata")
+    args = parser.parse_args()
+
+    ok = True
+    for path in args.objects:
+        ok = check(args.objdump, path, tuple(args.allow)) and ok
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
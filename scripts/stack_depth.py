@@ -0,0 +1,250 @@
+#!/usr/bin/env python3
+"""Static worst-case stack depth for the firmware image.
+
+Usage:
+    stack_depth.py [--objdump PATH] [--ld partitions_memory.ld] [--region data]
+                   [--icall FUNC]... [--callgraph OUT] IMAGE.elf FILE.su...
+
+Frames come from the -fstack-usage files (.su) the compiler leaves next to
+each object. Functions without one (assembly, libgcc) get an estimate: one
+byte per `push`, two per `rcall .+0`. The call graph comes from the linked
+image's disassembly:
+
+    call/rcall X      X runs with our frame and a 2-byte return address
+    jmp/rjmp X        tail jump; counted as if our frame were still live
+    icall/eicall      may reach any function given with --icall; a name
+                      also matches its LTO clones (uart_sink.lto_priv.0,
+                      uart_sink.constprop.0), and one that matches nothing
+                      in the image is an error
+    ijmp/eijmp        switch tables, which stay inside the function
+
+Depth is measured from RAMEND down. main starts 2 bytes deep (the call
+from .init9). Each interrupt adds 2 bytes for the hardware-pushed PC plus
+the deepest path of its __vector_N. An ISR that executes `sei` can nest,
+so all such ISRs are summed. The rest cannot nest, so only the deepest
+one counts.
+
+The budget is a MEMORY region (default `data`, from the generated
+partitions_memory.ld). The worst case plus .data, .bss and .noinit must fit
+in it, or the script exits with status 1. Recursion and unresolved indirect calls are errors too.
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+
+RETURN_ADDR = 2
+
+SYMBOL = re.compile(r"^([0-9a-f]+) <([^>]+)>:$")
+BRANCH = re.compile(r"\t(call|rcall|jmp|rjmp)\t.*;\s*0x[0-9a-f]+ <([^>+]+)(\+0x[0-9a-f]+)?>")
+INDIRECT_CALL = re.compile(r"\t(e?icall)\b")
+PUSH = re.compile(r"\tpush\t")
+RCALL_ZERO = re.compile(r"\trcall\t\.\+0\b")
+SEI = re.compile(r"\tsei\b")
+SECTION = re.compile(r"^\s*\d+\s+(\.\S+)\s+([0-9a-f]+)\s")
+REGION = r"\b%s\s*\([^)]*\)\s*:\s*ORIGIN\s*=\s*(0x[0-9a-fA-F]+|\d+)\s*,\s*LENGTH\s*=\s*(\d+)\s*([KM]?)"
+
+
+class Function:
+    def __init__(self, name):
+        self.name = name
+        self.calls = set()
+        self.jumps = set()
+        self.indirect = False
+        self.pushes = 0
+        self.sei = False
+
+
+def disassemble(objdump, elf):
+    out = subprocess.run([objdump, "-d", elf], stdout=subprocess.PIPE, check=True)
+    funcs = {}
+    current = None
+    for line in out.stdout.decode("latin-1").splitlines():
+        m = SYMBOL.match(line)
+        if m:
+            current = funcs.setdefault(m.group(2), Function(m.group(2)))
+            continue
+        if current is None:
+            continue
+        m = BRANCH.search(line)
+        if m and m.group(2) != current.name:
+            if m.group(1).endswith("call"):
+                current.calls.add(m.group(2))
+            else:
+                current.jumps.add(m.group(2))
+        if INDIRECT_CALL.search(line):
+            current.indirect = True
+        if PUSH.search(line):
+            current.pushes += 1
+        if RCALL_ZERO.search(line):
+            current.pushes += 2
+        if SEI.search(line):
+            current.sei = True
+    return funcs
+
+
+def read_frames(paths):
+    frames = {}
+    dynamic = []
+    for path in paths:
+        with open(path) as f:
+            for line in f:
+                fields = line.rstrip("\n").split("\t")
+                if len(fields) < 3:
+                    continue
+                name = fields[0].rsplit(":", 1)[-1]
+                size = int(fields[1])
+                # Static functions may share a name across files: keep the worst
+                frames[name] = max(size, frames.get(name, 0))
+                if fields[2].startswith("dynamic") and fields[2] != "dynamic,bounded":
+                    dynamic.append(name)
+    return frames, dynamic
+
+
+def section_sizes(objdump, elf):
+    out = subprocess.run([objdump, "-h", elf], stdout=subprocess.PIPE, check=True)
+    sizes = {}
+    for line in out.stdout.decode("latin-1").splitlines():
+        m = SECTION.match(line)
+        if m:
+            sizes[m.group(1)] = int(m.group(2), 16)
+    return sizes
+
+
+def region(ld_script, name):
+    with open(ld_script) as f:
+        m = re.search(REGION % re.escape(name), f.read())
+    if not m:
+        raise SystemExit("error: no MEMORY region '%s' in %s" % (name, ld_script))
+    scale = {"": 1, "K": 1024, "M": 1024 * 1024}[m.group(3)]
+    return int(m.group(1), 0), int(m.group(2)) * scale
+
+
+class Analyzer:
+    def __init__(self, funcs, frames, icall_targets):
+        self.funcs = funcs
+        self.frames = frames
+        self.icall_targets = icall_targets
+        self.memo = {}
+        self.estimated = set()
+        self.errors = []
+
+    def frame(self, name):
+        if name in self.frames:
+            return self.frames[name]
+        self.estimated.add(name)
+        func = self.funcs.get(name)
+        return func.pushes if func else 0
+
+    def depth(self, name, stack=()):
+        """Deepest stack use of name including its own frame -> (bytes, path)"""
+        if name in self.memo:
+            return self.memo[name]
+        if name in stack:
+            self.errors.append("recursion: %s" % " > ".join(stack + (name,)))
+            return 0, [name]
+        func = self.funcs.get(name) or Function(name)
+        callees = [(c, RETURN_ADDR) for c in sorted(func.calls)]
+        callees += [(j, 0) for j in sorted(func.jumps)]
+        if func.indirect:
+            if not self.icall_targets:
+                self.errors.append("unresolved indirect call in %s (use --icall)" % name)
+            callees += [(t, RETURN_ADDR) for t in self.icall_targets]
+        best, best_path = 0, []
+        for callee, extra in callees:
+            d, path = self.depth(callee, stack + (name,))
+            if d + extra > best:
+                best, best_path = d + extra, path
+        result = (self.frame(name) + best, [name] + best_path)
+        self.memo[name] = result
+        return result
+
+
+def resolve_icall(funcs, names):
+    """Image symbols for each --icall name -> (targets, missing names)"""
+    targets, missing = [], []
+    for name in names:
+        found = sorted(f for f in funcs if f == name or f.startswith(name + "."))
+        if found:
+            targets += found
+        else:
+            missing.append(name)
+    return targets, missing
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("--objdump", default="avr-objdump")
+    ap.add_argument("--ld", default="linkers/partitions_memory.ld")
+    ap.add_argument("--region", default="data")
+    ap.add_argument("--icall", action="append", default=[], metavar="FUNC",
+                    help="possible target of every indirect call (repeatable)")
+    ap.add_argument("--callgraph", help="write frames and call edges here")
+    ap.add_argument("elf")
+    ap.add_argument("su", nargs="*")
+    args = ap.parse_args()
+
+    funcs = disassemble(args.objdump, args.elf)
+    frames, dynamic = read_frames(args.su)
+    icall, missing = resolve_icall(funcs, args.icall)
+    if missing:
+        # Inlined, renamed or dropped: the indirect calls would be unbounded
+        raise SystemExit("error: --icall %s not found in %s"
+                         % (", ".join(missing), args.elf))
+    an = Analyzer(funcs, frames, icall)
+
+    main_depth, main_path = an.depth("main")
+    main_depth += RETURN_ADDR
+    isrs = sorted(n for n in funcs if re.fullmatch(r"__vector_\d+", n))
+    nested, single, worst_isr = 0, 0, []
+    for isr in isrs:
+        d, path = an.depth(isr)
+        d += RETURN_ADDR
+        if funcs[isr].sei:
+            nested += d
+        elif d > single:
+            single, worst_isr = d, path
+    total = main_depth + single + nested
+
+    if args.callgraph:
+        with open(args.callgraph, "w") as f:
+            for name in sorted(an.memo):
+                func = funcs.get(name) or Function(name)
+                tag = " (est.)" if name in an.estimated else ""
+                f.write("%s: frame=%d%s depth=%d\n" % (name, an.frame(name), tag, an.memo[name][0]))
+                for callee in sorted(func.calls):
+                    f.write("    call %s\n" % callee)
+                for callee in sorted(func.jumps):
+                    f.write("    jump %s\n" % callee)
+                if func.indirect:
+                    f.write("    icall %s\n" % " ".join(icall))
+
+    sizes = section_sizes(args.objdump, args.elf)
+    static = sum(sizes.get(s, 0) for s in (".data", ".bss", ".noinit"))
+    origin, length = region(args.ld, args.region)
+
+    print("stack: main %d bytes: %s" % (main_depth, " > ".join(main_path)))
+    if worst_isr:
+        print("stack: isr  %d bytes: %s" % (single, " > ".join(worst_isr)))
+    if nested:
+        print("stack: nestable isrs %d bytes" % nested)
+    print("stack: worst case %d + static %d (.data=%d .bss=%d .noinit=%d) = %d of %d (region %s @ 0x%06x)"
+          % (total, static, sizes.get(".data", 0), sizes.get(".bss", 0), sizes.get(".noinit", 0),
+             total + static, length, args.region, origin))
+    if an.estimated:
+        print("stack: frames estimated from pushes: %s" % " ".join(sorted(an.estimated)))
+    for name in dynamic:
+        print("warning: %s has a dynamic frame; its size is a lower bound" % name, file=sys.stderr)
+
+    for err in an.errors:
+        print("error: %s" % err, file=sys.stderr)
+    if total + static > length:
+        print("error: stack overflows the %s region by %d bytes"
+              % (args.region, total + static - length), file=sys.stderr)
+        return 1
+    return 1 if an.errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
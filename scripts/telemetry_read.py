@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Read the firmware's UART output: COBS telemetry frames or plain text.
+
+Usage:
+    telemetry_read.py [--baud N] [--duration S] [--text] [--dump FILE] [PORT_OR_FILE]
+
+PORT_OR_FILE defaults to /dev/cu.usbserial-110. A serial device is switched
+to raw 8N1 at --baud (default 9600), which must be a standard termios
+rate; a regular file (capture) is read as is.
+
+Without --text the stream is split on 0x00, COBS-decoded and checked:
+
+    [type][seq][len][payload][crc16 lo][crc16 hi]
+
+CRC is CRC-16/CCITT-FALSE over type..payload. Gaps in seq are reported as
+dropped frames. TM_TYPE_BUFFER chunks are reassembled per partition and can
+be written to --dump as one binary file per partition.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import termios
+import time
+
+TYPE_SIGNATURE = 0x01
+TYPE_ADDRESSES = 0x02
+TYPE_BUFFER = 0x03
+TYPE_STATS = 0x04
+TYPE_TRACE = 0x05
+
+RESET_FLAGS = ((0x01, "power-on"), (0x02, "external"), (0x04, "brown-out"), (0x08, "watchdog"))
+TRACE_STATES = {0: "invalid", 1: "sealed", 2: "unsealed"}
+
+PARTITIONS = {0: ("buffer_128", 128), 1: ("buffer_256", 256), 2: ("buffer_640", 640)}
+
+# Standard rates this platform's termios knows; others would need BOTHER
+BAUD_CONSTANTS = {rate: getattr(termios, "B%d" % rate) for rate in
+                  (1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200,
+                   230400, 460800, 500000, 576000, 921600, 1000000)
+                  if hasattr(termios, "B%d" % rate)}
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(block):
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        code = block[i]
+        if code == 0 or i + code > len(block):
+            raise ValueError("bad COBS block")
+        out += block[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(block):
+            out.append(0)
+    return bytes(out)
+
+
+def open_input(path, baud):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        if baud not in BAUD_CONSTANTS:
+            os.close(fd)
+            raise ValueError("unsupported baud rate %d, use one of %s"
+                             % (baud, " ".join(str(b) for b in sorted(BAUD_CONSTANTS))))
+        attrs = termios.tcgetattr(fd)
+        attrs[0] = 0                                                # iflag: raw
+        attrs[1] = 0                                                # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL     # 8N1
+        attrs[3] = 0                                                # lflag
+        attrs[4] = attrs[5] = BAUD_CONSTANTS[baud]
+        attrs[6][termios.VMIN] = 0
+        attrs[6][termios.VTIME] = 1
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+class Decoder:
+    def __init__(self):
+        self.expected_seq = None
+        self.frames = 0
+        self.dropped = 0
+        self.crc_errors = 0
+        self.buffers = {pid: bytearray(size) for pid, (_, size) in PARTITIONS.items()}
+        self.filled = {pid: set() for pid in PARTITIONS}
+
+    def feed_block(self, block):
+        try:
+            frame = cobs_decode(block)
+        except ValueError:
+            self.crc_errors += 1
+            return
+        if len(frame) < 5 or frame[2] != len(frame) - 5:
+            self.crc_errors += 1
+            return
+        body, crc = frame[:-2], frame[-2] | (frame[-1] << 8)
+        if crc16(body) != crc:
+            self.crc_errors += 1
+            return
+
+        ftype, seq, length = body[0], body[1], body[2]
+        payload = body[3:]
+        if self.expected_seq is not None and seq != self.expected_seq:
+            lost = (seq - self.expected_seq) & 0xFF
+            self.dropped += lost
+            print("!! %d frame(s) dropped before seq %d" % (lost, seq))
+        self.expected_seq = (seq + 1) & 0xFF
+        self.frames += 1
+        self.show(ftype, seq, payload)
+
+    def show(self, ftype, seq, payload):
+        if ftype == TYPE_SIGNATURE:
+            print("[%3d] signature %s" % (seq, " ".join("%02X" % b for b in payload)))
+        elif ftype == TYPE_ADDRESSES:
+            addrs = struct.unpack("<%dH" % (len(payload) // 2), payload)
+            print("[%3d] addresses %s" % (seq, " ".join("0x%04x" % a for a in addrs)))
+        elif ftype == TYPE_BUFFER:
+            pid, offset = payload[0], payload[1] | (payload[2] << 8)
+            data = payload[3:]
+            name, size = PARTITIONS.get(pid, ("part%d" % pid, 0))
+            if pid in self.buffers and offset + len(data) <= size:
+                self.buffers[pid][offset:offset + len(data)] = data
+                self.filled[pid].update(range(offset, offset + len(data)))
+            print("[%3d] %s[%d..%d]" % (seq, name, offset, offset + len(data) - 1))
+        elif ftype == TYPE_STATS:
+            fields = struct.unpack("<BBHHHH", payload[:10])
+            print("[%3d] stats tx_pending=%d tx_high_water=%d tx_stalls=%d "
+                  "rx_dropped=%d rx_errors=%d frames=%d" % ((seq,) + fields))
+        elif ftype == TYPE_TRACE:
+            cause, state, head, count, boots = payload[:5]
+            ring = payload[5:]
+            flags = [name for bit, name in RESET_FLAGS if cause & bit]
+            print("[%3d] reset cause 0x%02x (%s), trace %s, %d records, %d boots"
+                  % (seq, cause, " ".join(flags) or "none", TRACE_STATES.get(state, state),
+                     count, boots))
+            size = len(ring) // 4
+            for n in range(count if size else 0):
+                i = (head - count + n) % size
+                rid, arg8, arg16 = struct.unpack_from("<BBH", ring, i * 4)
+                print("      id=%d arg8=%d arg16=%d" % (rid, arg8, arg16))
+        else:
+            print("[%3d] type 0x%02x, %d bytes" % (seq, ftype, len(payload)))
+
+    def summary(self, dump):
+        print("---")
+        print("frames=%d dropped=%d crc_errors=%d" % (self.frames, self.dropped, self.crc_errors))
+        for pid, (name, size) in PARTITIONS.items():
+            print("%s: %d/%d bytes received" % (name, len(self.filled[pid]), size))
+            if dump and self.filled[pid]:
+                with open("%s.%s.bin" % (dump, name), "wb") as f:
+                    f.write(self.buffers[pid])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", nargs="?", default="/dev/cu.usbserial-110")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--duration", type=float, default=0,
+                        help="stop after this many seconds (0 = until EOF/Ctrl-C)")
+    parser.add_argument("--text", action="store_true", help="print raw text instead of decoding frames")
+    parser.add_argument("--dump", help="write reassembled partitions to DUMP.<name>.bin")
+    args = parser.parse_args()
+
+    try:
+        fd = open_input(args.port, args.baud)
+    except ValueError as exc:
+        print("error: %s" % exc, file=sys.stderr)
+        return 1
+    decoder = Decoder()
+    pending = bytearray()
+    deadline = time.time() + args.duration if args.duration else None
+
+    try:
+        while deadline is None or time.time() < deadline:
+            chunk = os.read(fd, 4096)
+            if not chunk:
+                if not os.isatty(fd):
+                    break
+                continue
+            if args.text:
+                sys.stdout.write(chunk.decode("latin-1"))
+                sys.stdout.flush()
+                continue
+            pending += chunk
+            while 0 in pending:
+                end = pending.index(0)
+                if end:
+                    decoder.feed_block(bytes(pending[:end]))
+                del pending[:end + 1]
+    except KeyboardInterrupt:
+        pass
+    finally:
+        os.close(fd)
+
+    if not args.text:
+        decoder.summary(args.dump)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Decode deferred ULOG records back into text.
+
+Usage:
+    ulog_decode.py TABLE [INPUT]
+    ulog_decode.py --check TABLE
+
+TABLE is either the firmware ELF or the raw descriptor table produced by
+`make ULOG=deferred ulog` (build/<profile>/hello.ulog). INPUT is a capture file or a serial device
+already configured with stty (default: stdin), e.g.
+
+    stty -f /dev/cu.usbserial-110 115200 raw
+    ./scripts/ulog_decode.py build/debug/hello.elf /dev/cu.usbserial-110
+
+Wire format per record: [id lo][id hi][args...][crc16 lo][crc16 hi],
+COBS-encoded between two 0x00 delimiters. id is the offset of the call
+site's descriptor in .ulog_fmt; the CRC covers id and args. A descriptor is
+the argument kinds ('1', '2', '4', '8' = little-endian byte count, 's' =
+length-prefixed string) terminated by NUL, followed by the NUL-terminated
+format string. Anything between delimiters that is not a valid record
+(plain uprintf text on the same UART) is printed as is.
+
+--check validates every descriptor against avr-gcc's type sizes and exits
+with status 1 on a conversion ULOG cannot defer (%S, unknown ones), a
+conversion/argument count mismatch or an argument of the wrong kind. The
+build runs it on every ULOG=deferred image.
+"""
+
+import re
+import struct
+import sys
+
+from telemetry_read import cobs_decode, crc16
+
+CONVERSION = re.compile(r"%(l?)([diuxXcsSp%])")
+ANY_CONVERSION = re.compile(r"%(l?)(.?)", re.S)
+
+# avr-gcc: int and pointers are 2 bytes, long 4
+INT_KINDS = "12"
+LONG_KINDS = "4"
+
+
+def section_from_elf(data, name):
+    if data[4] != 1 or data[5] != 1:
+        sys.exit("only 32-bit little-endian ELF files are supported")
+    shoff, = struct.unpack_from("<I", data, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+    def header(i):
+        return struct.unpack_from("<IIIIIIIIII", data, shoff + i * shentsize)
+
+    strtab = header(shstrndx)
+    for i in range(shnum):
+        sh = header(i)
+        start = strtab[4] + sh[0]
+        sec_name = data[start:data.index(b"\0", start)].decode()
+        if sec_name == name:
+            return data[sh[4]:sh[4] + sh[5]]
+    sys.exit("section %s not found (was the firmware built with ULOG=deferred?)" % name)
+
+
+def load_table(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] == b"\x7fELF":
+        data = section_from_elf(data, ".ulog_fmt")
+
+    table = {}
+    pos = 0
+    while pos < len(data):
+        kinds_end = data.index(b"\0", pos)
+        fmt_end = data.index(b"\0", kinds_end + 1)
+        table[pos] = (data[pos:kinds_end].decode(), data[kinds_end + 1:fmt_end].decode("latin-1"))
+        pos = fmt_end + 1
+    return table
+
+
+def parse_args(data, kinds):
+    """Split a record's argument bytes by kinds; None unless they fit exactly."""
+    args = []
+    pos = 0
+    for kind in kinds:
+        if kind == "s":
+            if pos >= len(data):
+                return None
+            length = data[pos]
+            args.append(data[pos + 1:pos + 1 + length].decode("latin-1"))
+            pos += 1 + length
+        else:
+            args.append(data[pos:pos + int(kind)])
+            pos += int(kind)
+        if pos > len(data):
+            return None
+    return args if pos == len(data) else None
+
+
+def decode_record(table, block):
+    """Text of one delimited block if it is a valid record, else None."""
+    try:
+        frame = cobs_decode(block)
+    except ValueError:
+        return None
+    if len(frame) < 4 or crc16(frame[:-2]) != frame[-2] | (frame[-1] << 8):
+        return None
+    record_id = frame[0] | (frame[1] << 8)
+    if record_id not in table:
+        return None
+    kinds, fmt = table[record_id]
+    args = parse_args(frame[2:-2], kinds)
+    return None if args is None else render(fmt, args)
+
+
+def check_table(table):
+    errors = []
+    for offset, (kinds, fmt) in sorted(table.items()):
+        where = "descriptor 0x%04x %r" % (offset, fmt)
+        queue = list(kinds)
+        for match in ANY_CONVERSION.finditer(fmt):
+            long_, conv = match.groups()
+            if conv == "%" and not long_:
+                continue
+            if conv == "S":
+                errors.append("%s: %%S has no deferred form, pass a RAM string to %%s" % where)
+                continue
+            if conv not in "diuxXcsp" or (long_ and conv not in "diuxX"):
+                errors.append("%s: unsupported conversion %s" % (where, match.group(0)))
+                continue
+            if not queue:
+                errors.append("%s: more conversions than arguments" % where)
+                break
+            kind = queue.pop(0)
+            if conv == "s":
+                ok = kind == "s"
+            elif long_:
+                ok = kind in LONG_KINDS
+            else:
+                ok = kind in INT_KINDS
+            if not ok:
+                errors.append("%s: %s given a %s argument"
+                              % (where, match.group(0), "string" if kind == "s" else kind + "-byte"))
+        if queue:
+            errors.append("%s: more arguments than conversions" % where)
+    return errors
+
+
+def render(fmt, args):
+    queue = list(args)
+
+    def convert(match):
+        conv = match.group(2)
+        if conv == "%":
+            return "%"
+        if not queue:
+            return match.group(0)
+        arg = queue.pop(0)
+        if isinstance(arg, str):
+            return arg
+        signed = conv in "di"
+        value = int.from_bytes(arg, "little", signed=signed)
+        if conv in "di" or conv == "u":
+            return str(value)
+        if conv == "x":
+            return "%x" % value
+        if conv == "X":
+            return "%X" % value
+        if conv == "c":
+            return chr(value & 0xFF)
+        if conv == "p":
+            return "0x%06x" % value
+        return match.group(0)
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def main():
+    if len(sys.argv) == 3 and sys.argv[1] == "--check":
+        errors = check_table(load_table(sys.argv[2]))
+        for error in errors:
+            print("error: %s" % error, file=sys.stderr)
+        return 1 if errors else 0
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    table = load_table(sys.argv[1])
+    if len(sys.argv) > 2 and sys.argv[2] != "-":
+        stream = open(sys.argv[2], "rb", buffering=0)
+    else:
+        stream = sys.stdin.buffer
+    read = getattr(stream, "read1", stream.read)
+
+    pending = b""
+    try:
+        while True:
+            chunk = read(4096)
+            if not chunk:
+                break
+            pending += chunk
+            *blocks, pending = pending.split(b"\0")
+            for block in blocks:
+                if not block:
+                    continue
+                text = decode_record(table, block)
+                if text is None:
+                    text = block.decode("latin-1")
+                sys.stdout.write(text.replace("\r\n", "\n"))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    # Text after the last record
+    sys.stdout.write(pending.decode("latin-1").replace("\r\n", "\n"))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
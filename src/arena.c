@@ -0,0 +1,69 @@
+#include "arena.h"
+#include "uart_com.h"
+#include "partitions.h"
+#include "trace.h"
+#include "startup.h"
+#include "blk.h"
+
+#include <avr/pgmspace.h>
+
+
+arena_t arena_frame STARTUP_DONTCARE;  // set up by arena_frame_init()
+
+void arena_init(arena_t* a, void* base, void* end)
+{
+    a->base = (uint8_t*)base;
+    a->end = (uint8_t*)end;
+    a->top = a->base;
+    a->peak = 0;
+    a->failures = 0;
+#ifdef ARENA_DEBUG
+    blk_fill(a->base, ARENA_POISON, a->end - a->base);
+#endif
+}
+
+void arena_frame_init(void)
+{
+    arena_init(&arena_frame, __buffer_640_free, __buffer_640_end);
+}
+
+void* arena_alloc_aligned(arena_t* a, uint16_t size, uint8_t align)
+{
+    uintptr_t addr = (uintptr_t)a->top;
+    uintptr_t aligned = (addr + (align - 1)) & ~(uintptr_t)(align - 1);
+    uint8_t* p = (uint8_t*)aligned;
+
+    if (p > a->end || size > (uint16_t)(a->end - p)) {
+        if (a->failures != 0xFFFF) {
+            a->failures++;
+        }
+        trace(TRACE_EV_ALLOC, 1, size);
+        return 0;
+    }
+    a->top = p + size;
+
+    uint16_t used = arena_used(a);
+    if (used > a->peak) {
+        a->peak = used;
+    }
+    return p;
+}
+
+void arena_rollback(arena_t* a, arena_mark_t mark)
+{
+    uint8_t* p = a->base + mark;
+
+    if (p >= a->top) {
+        return;
+    }
+#ifdef ARENA_DEBUG
+    blk_fill(p, ARENA_POISON, a->top - p);
+#endif
+    a->top = p;
+}
+
+void arena_print_stats(const arena_t* a)
+{
+    uprintf_P(PSTR("arena base=%p size=%u used=%u peak=%u fails=%u\r\n"),
+              (void*)a->base, arena_capacity(a), arena_used(a), a->peak, a->failures);
+}
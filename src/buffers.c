@@ -0,0 +1,45 @@
+#include "buffers.h"
+#include "startup.h"
+
+#include <avr/pgmspace.h>
+#include <string.h>
+
+_Static_assert(UART_RX_RING_SIZE < PARTITION_BUFFER_128_SIZE,
+               "UART RX ring leaves no room in .buffer_128");
+_Static_assert(BUFFER_640_APP_SIZE + UART_TX_RING_SIZE <= PARTITION_BUFFER_640_SIZE,
+               "buffer_640 and the UART TX ring exceed .buffer_640");
+_Static_assert(BUFFER_128_APP_SIZE >= 64 && BUFFER_640_APP_SIZE >= 128,
+               "demo images do not fit the application buffers");
+
+// Byte ramps n, n+1, ... for the demo images
+#define RAMP4(n) (n), (n) + 1, (n) + 2, (n) + 3
+#define RAMP16(n) RAMP4(n), RAMP4((n) + 4), RAMP4((n) + 8), RAMP4((n) + 12)
+#define RAMP64(n) RAMP16(n), RAMP16((n) + 16), RAMP16((n) + 32), RAMP16((n) + 48)
+
+// Demo pattern: buffer_128[i] = i, buffer_640[i] = (uint8_t)(i + 384).
+// With partition sections both are initial images, loaded from flash at
+// startup instead of being computed.
+#ifdef BUFFER_SECTION_ATTRIBUTE
+uint8_t buffer_128[BUFFER_128_APP_SIZE] PARTITION_IMAGE(buffer_128) = { RAMP64(0) };
+uint8_t buffer_640[BUFFER_640_APP_SIZE] PARTITION_IMAGE(buffer_640) = { RAMP64(128), RAMP64(192) };
+#else
+uint8_t buffer_128[BUFFER_128_APP_SIZE] = { RAMP64(0) };
+uint8_t buffer_640[BUFFER_640_APP_SIZE] = { RAMP64(128), RAMP64(192) };
+#endif
+
+void fill_buffers(void)
+{
+#ifdef BUFFER_SECTION_ATTRIBUTE
+    memcpy_P(__buffer_128_image_start, __buffer_128_image_load,
+             __buffer_128_image_end - __buffer_128_image_start);
+    memcpy_P(__buffer_640_image_start, __buffer_640_image_load,
+             __buffer_640_image_end - __buffer_640_image_start);
+#else
+    for (uint8_t i = 0; i < BUFFER_128_APP_SIZE; i++) {
+        buffer_128[i] = i;
+    }
+    for (uint8_t i = 0; i < BUFFER_640_APP_SIZE; i++) {
+        buffer_640[i] = (uint8_t)(i + 384);
+    }
+#endif
+}
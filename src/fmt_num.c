@@ -0,0 +1,153 @@
+#include "fmt_num.h"
+
+#include <avr/pgmspace.h>
+
+static const uint16_t pow10_16[] PROGMEM = { 10000, 1000, 100, 10 };
+
+static const uint32_t pow10_32[] PROGMEM = {
+    1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL
+};
+
+uint8_t fmt_u8(char* out, uint8_t val)
+{
+    char* p = out;
+
+    if (val >= 100) {
+        char d = '1';
+        val -= 100;
+        if (val >= 100) {
+            d++;
+            val -= 100;
+        }
+        *p++ = d;
+        // Tens digit is significant even when zero
+        char t = '0';
+        while (val >= 10) {
+            val -= 10;
+            t++;
+        }
+        *p++ = t;
+    } else if (val >= 10) {
+        char t = '0';
+        while (val >= 10) {
+            val -= 10;
+            t++;
+        }
+        *p++ = t;
+    }
+    *p++ = '0' + val;
+    return (uint8_t)(p - out);
+}
+
+// Emit the digits of val for 10^4 down to 10^1; started forces leading zeros
+static char* u16_digits(char* p, uint16_t val, uint8_t started)
+{
+    for (uint8_t i = 0; i < 4; i++) {
+        uint16_t pw = pgm_read_word(&pow10_16[i]);
+        char d = '0';
+        while (val >= pw) {
+            val -= pw;
+            d++;
+        }
+        if (d != '0' || started) {
+            *p++ = d;
+            started = 1;
+        }
+    }
+    *p++ = '0' + (uint8_t)val;
+    return p;
+}
+
+uint8_t fmt_u16(char* out, uint16_t val)
+{
+    if (val < 256) {
+        return fmt_u8(out, (uint8_t)val);
+    }
+    return (uint8_t)(u16_digits(out, val, 0) - out);
+}
+
+uint8_t fmt_u32(char* out, uint32_t val)
+{
+    if (val <= 0xFFFF) {
+        return fmt_u16(out, (uint16_t)val);
+    }
+
+    // Peel off 10^9..10^5 with 32-bit subtraction; the remainder is < 10^5
+    // but may still exceed 16 bits, so 10^4 is handled here too.
+    char* p = out;
+    uint8_t started = 0;
+    for (uint8_t i = 0; i < 5; i++) {
+        uint32_t pw = pgm_read_dword(&pow10_32[i]);
+        char d = '0';
+        while (val >= pw) {
+            val -= pw;
+            d++;
+        }
+        if (d != '0' || started) {
+            *p++ = d;
+            started = 1;
+        }
+    }
+    char d = '0';
+    while (val >= 10000) {
+        val -= 10000;
+        d++;
+    }
+    // The low five digits always print, zero-padded: val > 0xFFFF has at
+    // least five digits, so the 10^4 digit is never a leading zero. It is
+    // the first digit for 65536..99999 and follows the digits above it
+    // otherwise.
+    *p++ = d;
+    uint16_t rest = (uint16_t)val;
+    // Remaining four digits, zero-padded for the same reason
+    for (uint8_t i = 1; i < 4; i++) {
+        uint16_t pw = pgm_read_word(&pow10_16[i]);
+        char c = '0';
+        while (rest >= pw) {
+            rest -= pw;
+            c++;
+        }
+        *p++ = c;
+    }
+    *p++ = '0' + (uint8_t)rest;
+    return (uint8_t)(p - out);
+}
+
+uint8_t fmt_i16(char* out, int16_t val)
+{
+    if (val < 0) {
+        *out = '-';
+        return 1 + fmt_u16(out + 1, (uint16_t)(0U - (uint16_t)val));
+    }
+    return fmt_u16(out, (uint16_t)val);
+}
+
+uint8_t fmt_i32(char* out, int32_t val)
+{
+    if (val < 0) {
+        *out = '-';
+        return 1 + fmt_u32(out + 1, 0UL - (uint32_t)val);
+    }
+    return fmt_u32(out, (uint32_t)val);
+}
+
+uint8_t fmt_hex32(char* out, uint32_t val, uint8_t upper)
+{
+    char alpha = upper ? 'A' - 10 : 'a' - 10;
+    uint8_t shift = 28;
+
+    // Skip leading zero nibbles, keeping at least one digit
+    while (shift && !((val >> shift) & 0xF)) {
+        shift -= 4;
+    }
+    char* p = out;
+    for (;;) {
+        uint8_t nibble = (val >> shift) & 0xF;
+        *p++ = nibble < 10 ? '0' + nibble : alpha + nibble;
+        if (shift == 0) {
+            break;
+        }
+        shift -= 4;
+    }
+    return (uint8_t)(p - out);
+}
@@ -0,0 +1,356 @@
+#include "kv.h"
+#include "crc16.h"
+#include "uart_com.h"
+#include "startup.h"
+#include "blk.h"
+#include "prof.h"
+
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+#define KV_RECORD_OVERHEAD 4            // key, len, crc16
+#define KV_RECORD_MAX (KV_RECORD_OVERHEAD + KV_MAX_VALUE)
+#define KV_END 0xFF                     // erased byte: end of page / unused page
+#define KV_SEQ_MAX 0xFE                 // sequence numbers run 0..0xFE
+
+#define KV_DIRTY 0x01                   // value differs from the EEPROM
+#define KV_EVAC  0x02                   // record sits in the page about to be reused
+
+_Static_assert(KV_MAX_KEYS < KV_END, "keys must stay below 0xFF");
+_Static_assert((uint32_t)KV_PAGES * KV_PAGE_SIZE <= E2END + 1, "store exceeds the EEPROM");
+_Static_assert(KV_PAGE_SIZE <= 255, "page offsets are 8-bit");
+// Every key's largest record must fit with two pages to spare (the head and
+// the one being evacuated), or page reuse cannot keep up
+_Static_assert(KV_MAX_KEYS * KV_RECORD_MAX <= (KV_PAGES - 2) * (KV_PAGE_SIZE - 1),
+               "too many keys for the store");
+
+typedef struct {
+    uint16_t addr;                      // EEPROM record address, 0xFFFF: none
+    uint8_t len;                        // KV_END: no value
+    uint8_t flags;
+    uint8_t value[KV_MAX_VALUE];
+} kv_slot_t;
+
+// Erased contents, so a flashed .eep image starts as an empty store
+static uint8_t kv_area[KV_PAGES][KV_PAGE_SIZE] EEMEM = {
+    [0 ... KV_PAGES - 1] = { [0 ... KV_PAGE_SIZE - 1] = KV_END }
+};
+
+// Both are fully written (kv_init/kv_poll) before they are read
+static kv_slot_t kv_slots[KV_MAX_KEYS] STARTUP_DONTCARE;
+static kv_stats_t kv_stats;
+
+// Record being written by the EE_READY interrupt. The last byte is the
+// end marker behind it; with kv_job_marker set it is written first, so a
+// torn write never exposes stale bytes from the page's previous lap.
+static uint8_t kv_job_buf[KV_RECORD_MAX + 1] STARTUP_DONTCARE;
+static uint16_t kv_job_addr;
+static uint8_t kv_job_len;
+static volatile uint8_t kv_job_pos;
+static volatile uint8_t kv_job_busy;
+static uint8_t kv_job_key;              // KV_END for a page header
+static uint8_t kv_job_marker;
+
+static uint16_t page_addr(uint8_t page)
+{
+    return (uint16_t)(uintptr_t)kv_area[page];
+}
+
+static uint8_t next_page(uint8_t page)
+{
+    return page + 1 == KV_PAGES ? 0 : page + 1;
+}
+
+static uint8_t next_seq(uint8_t seq)
+{
+    return seq == KV_SEQ_MAX ? 0 : seq + 1;
+}
+
+static uint16_t record_crc(const uint8_t* rec, uint8_t value_len)
+{
+    return crc16_update(CRC16_INIT, rec, 2 + value_len);
+}
+
+// Replay one page; returns the offset where parsing stopped, or
+// KV_PAGE_SIZE if the page ends in a damaged (torn) record
+static uint8_t replay_page(uint8_t page)
+{
+    uint8_t off = 1;
+    uint8_t rec[KV_RECORD_MAX];
+
+    while (off + KV_RECORD_OVERHEAD <= KV_PAGE_SIZE) {
+        uint16_t addr = page_addr(page) + off;
+        eeprom_read_block(rec, (const void*)addr, 2);
+        if (rec[0] == KV_END) {
+            return off;
+        }
+        uint8_t len = rec[1];
+        if (rec[0] >= KV_MAX_KEYS || len > KV_MAX_VALUE
+            || off + KV_RECORD_OVERHEAD + len > KV_PAGE_SIZE) {
+            return KV_PAGE_SIZE;
+        }
+        eeprom_read_block(rec + 2, (const void*)(addr + 2), len + 2);
+        uint16_t crc = rec[2 + len] | (uint16_t)rec[3 + len] << 8;
+        if (crc != record_crc(rec, len)) {
+            return KV_PAGE_SIZE;
+        }
+        kv_slot_t* s = &kv_slots[rec[0]];
+        s->addr = addr;
+        s->len = len;
+        blk_copy(s->value, rec + 2, len);
+        off += KV_RECORD_OVERHEAD + len;
+    }
+    return off;
+}
+
+// Flag every key whose current record lives in page with flag
+static void mark_page(uint8_t page, uint8_t flag)
+{
+    uint16_t start = page_addr(page);
+
+    for (uint8_t k = 0; k < KV_MAX_KEYS; k++) {
+        kv_slot_t* s = &kv_slots[k];
+        if (s->len != KV_END && (uint16_t)(s->addr - start) < KV_PAGE_SIZE) {
+            s->flags |= flag;
+        }
+    }
+}
+
+void kv_init(void)
+{
+    uint8_t seq[KV_PAGES];
+    uint8_t head = KV_END;
+
+    for (uint8_t k = 0; k < KV_MAX_KEYS; k++) {
+        kv_slots[k].addr = 0xFFFF;
+        kv_slots[k].len = KV_END;
+        kv_slots[k].flags = 0;
+    }
+    blk_fill(&kv_stats, 0, sizeof(kv_stats));
+    kv_job_busy = 0;
+    kv_job_len = 0;
+
+    for (uint8_t p = 0; p < KV_PAGES; p++) {
+        seq[p] = eeprom_read_byte(&kv_area[p][0]);
+    }
+    // Pages are opened in ring order with consecutive sequence numbers:
+    // the head is the used page whose successor does not continue the run
+    for (uint8_t p = 0; p < KV_PAGES; p++) {
+        uint8_t n = next_page(p);
+        if (seq[p] != KV_END && seq[n] != next_seq(seq[p])) {
+            head = p;
+            break;
+        }
+    }
+
+    if (head == KV_END) {
+        // Empty store: the first write opens page 0 with sequence 0
+        kv_stats.head_page = KV_PAGES - 1;
+        kv_stats.head_seq = KV_SEQ_MAX;
+        kv_stats.head_used = KV_PAGE_SIZE;
+        return;
+    }
+
+    // Oldest to newest, so later records win
+    uint8_t p = head;
+    do {
+        p = next_page(p);
+        if (seq[p] != KV_END) {
+            uint8_t used = replay_page(p);
+            if (p == head) {
+                kv_stats.head_used = used;
+            }
+        }
+    } while (p != head);
+    kv_stats.head_page = head;
+    kv_stats.head_seq = seq[head];
+    mark_page(next_page(head), KV_EVAC);
+}
+
+int8_t kv_get(uint8_t key, void* buf, uint8_t size)
+{
+    if (key >= KV_MAX_KEYS) {
+        return -1;
+    }
+    kv_slot_t* s = &kv_slots[key];
+    if (s->len == KV_END || s->len > size) {
+        return -1;
+    }
+    blk_copy(buf, s->value, s->len);
+    return s->len;
+}
+
+int8_t kv_set(uint8_t key, const void* data, uint8_t len)
+{
+    if (key >= KV_MAX_KEYS || len > KV_MAX_VALUE) {
+        return -1;
+    }
+    kv_slot_t* s = &kv_slots[key];
+    if (s->len == len && blk_compare(s->value, data, len) == 0) {
+        return 0;
+    }
+    blk_copy(s->value, data, len);
+    s->len = len;
+    s->flags |= KV_DIRTY;
+    return 0;
+}
+
+// Write kv_job_buf[0..len) at addr, plus an end marker behind it if the
+// page has room for one
+static void job_start(uint16_t addr, uint8_t len, uint8_t key)
+{
+    uint8_t end = (addr - page_addr(kv_stats.head_page)) + len;
+
+    kv_job_marker = end < KV_PAGE_SIZE;
+    if (kv_job_marker) {
+        kv_job_buf[len++] = KV_END;
+    }
+    kv_job_addr = addr;
+    kv_job_len = len;
+    kv_job_key = key;
+    kv_job_pos = 0;
+    kv_job_busy = 1;
+    EECR |= _BV(EERIE);
+}
+
+// Evacuations first: they must land before the head page fills up
+static uint8_t pick_key(void)
+{
+    for (uint8_t k = 0; k < KV_MAX_KEYS; k++) {
+        if (kv_slots[k].flags & KV_EVAC) {
+            return k;
+        }
+    }
+    for (uint8_t k = 0; k < KV_MAX_KEYS; k++) {
+        if (kv_slots[k].flags & KV_DIRTY) {
+            return k;
+        }
+    }
+    return KV_END;
+}
+
+void kv_poll(void)
+{
+    if (kv_job_busy) {
+        return;
+    }
+    if (kv_job_key != KV_END && kv_job_len) {
+        kv_slots[kv_job_key].addr = kv_job_addr;
+        kv_stats.records++;
+    }
+    kv_job_len = 0;
+
+    uint8_t key = pick_key();
+    if (key == KV_END) {
+        return;
+    }
+    kv_slot_t* s = &kv_slots[key];
+    uint8_t rec_len = KV_RECORD_OVERHEAD + s->len;
+
+    if (kv_stats.head_used + rec_len > KV_PAGE_SIZE) {
+        // Open the next page. Anything still living there was missed by the
+        // evacuation (e.g. reset mid-way); it is in RAM, so rewrite it.
+        uint8_t page = next_page(kv_stats.head_page);
+        mark_page(page, KV_DIRTY);
+        mark_page(next_page(page), KV_EVAC);
+        kv_stats.head_page = page;
+        kv_stats.head_seq = next_seq(kv_stats.head_seq);
+        kv_stats.head_used = 1;
+        kv_stats.pages_opened++;
+        kv_job_buf[0] = kv_stats.head_seq;
+        job_start(page_addr(page), 1, KV_END);
+        return;
+    }
+
+    kv_job_buf[0] = key;
+    kv_job_buf[1] = s->len;
+    blk_copy(kv_job_buf + 2, s->value, s->len);
+    uint16_t crc = record_crc(kv_job_buf, s->len);
+    kv_job_buf[2 + s->len] = crc & 0xFF;
+    kv_job_buf[3 + s->len] = crc >> 8;
+    s->flags &= ~(KV_DIRTY | KV_EVAC);
+
+    uint16_t addr = page_addr(kv_stats.head_page) + kv_stats.head_used;
+    kv_stats.head_used += rec_len;
+    job_start(addr, rec_len, key);
+}
+
+uint8_t kv_busy(void)
+{
+    return kv_job_busy || kv_job_len || pick_key() != KV_END;
+}
+
+void kv_flush(void)
+{
+    while (kv_busy()) {
+        kv_poll();
+    }
+}
+
+void kv_get_stats(kv_stats_t* out)
+{
+    kv_stats.dirty = 0;
+    for (uint8_t k = 0; k < KV_MAX_KEYS; k++) {
+        if (kv_slots[k].flags & (KV_DIRTY | KV_EVAC)) {
+            kv_stats.dirty++;
+        }
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        *out = kv_stats;
+    }
+}
+
+void kv_print_stats(void)
+{
+    kv_stats_t st;
+    kv_get_stats(&st);
+    uprintf_P(PSTR("kv head=%u seq=%u used=%u dirty=%u records=%u pages=%u written=%u skipped=%u\r\n"),
+              st.head_page, st.head_seq, st.head_used, st.dirty, st.records,
+              st.pages_opened, st.bytes_written, st.bytes_skipped);
+}
+
+// Level-triggered while EEPE is clear: one byte per interrupt. A byte that
+// already holds its value costs no write cycle, and the interrupt re-fires
+// immediately for the next one.
+static inline void kv_ee_ready(void)
+{
+    uint8_t pos = kv_job_pos;
+
+    if (pos == kv_job_len) {
+        EECR &= ~_BV(EERIE);
+        kv_job_busy = 0;
+        return;
+    }
+    kv_job_pos = pos + 1;
+    if (kv_job_marker) {
+        // Marker (last byte) first, then the record from its start
+        pos = pos == 0 ? kv_job_len - 1 : pos - 1;
+    }
+    uint8_t b = kv_job_buf[pos];
+
+    EEAR = kv_job_addr + pos;
+    EECR |= _BV(EERE);
+    if (EEDR == b) {
+        kv_stats.bytes_skipped++;
+        return;
+    }
+    EEDR = b;
+    // EEPE must follow EEMPE within four cycles
+    __asm__ volatile (
+        "sbi %[eecr], %[eempe]\n\t"
+        "sbi %[eecr], %[eepe]\n\t"
+        :
+        : [eecr] "I" (_SFR_IO_ADDR(EECR)), [eempe] "I" (EEMPE), [eepe] "I" (EEPE)
+    );
+    kv_stats.bytes_written++;
+}
+
+ISR(EE_READY_vect)
+{
+    PROF_BEGIN(PROF_KV_ISR);
+    kv_ee_ready();
+    PROF_END(PROF_KV_ISR);
+}
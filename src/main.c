@@ -1,12 +1,24 @@
-#define F_CPU 16000000UL
-#define BAUD 9600
-#define MYUBRR F_CPU/16/BAUD-1
-
 #include <avr/io.h>
-#include <util/delay.h>
+#include <avr/interrupt.h>
 #include <avr/boot.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+#include <avr/sleep.h>
 #include <string.h>
+#include <stdlib.h>
 #include "uart_com.h"
+#include "ulog.h"
+#include "telemetry.h"
+#include "buffers.h"
+#include "partitions.h"
+#include "pool.h"
+#include "arena.h"
+#include "stack.h"
+#include "trace.h"
+#include "kv.h"
+#include "prof.h"
+#include "pcprof.h"
+#include "tick.h"
 
 // void malloc(void) __attribute__((error("malloc is forbidden on this platform")));
 // void free(void) __attribute__((error("free is forbidden on this platform")));
@@ -16,56 +28,169 @@
 void print_signature(uint8_t sig[]);
 
 
-// Define buffers directly with section attributes
-#ifdef BUFFER_SECTION_ATTRIBUTE
-uint8_t buffer_128[128] __attribute__((section(".buffer_128")));
-uint8_t buffer_256[256] __attribute__((section(".buffer_256")));
-uint8_t buffer_640[640] __attribute__((section(".buffer_640")));
-#else
-uint8_t buffer_128[128];
-uint8_t buffer_256[256];
-uint8_t buffer_640[640];
-#endif
+int a; // stack
+int b = 1; // .data
+int c = 0; // .bss
+
+#ifdef TELEMETRY_BINARY
 
-void fill_buffers()
+static void telemetry_dump(const uint8_t sig[])
 {
-    for (int i = 0; i < 128; i++) {
-        buffer_128[i] = (uint8_t)i;
-    }
-    for (int i = 0; i < 256; i++) {
-        buffer_256[i] = (uint8_t)(i + 128);
-    }
-    for (int i = 0; i < 640; i++) {
-        buffer_640[i] = (uint8_t)(i + 384);
+    // Scratch from the frame arena, released at the end of the iteration
+    uint16_t* addrs = arena_alloc_aligned(&arena_frame, 6 * sizeof(uint16_t), sizeof(uint16_t));
+
+    telemetry_send(TM_TYPE_SIGNATURE, sig, 3, 0, 0);
+    if (addrs) {
+        addrs[0] = (uint16_t)(uintptr_t)&a;
+        addrs[1] = (uint16_t)(uintptr_t)&b;
+        addrs[2] = (uint16_t)(uintptr_t)&c;
+        addrs[3] = (uint16_t)(uintptr_t)buffer_128;
+        addrs[4] = (uint16_t)(uintptr_t)__buffer_256_start;
+        addrs[5] = (uint16_t)(uintptr_t)buffer_640;
+        telemetry_send(TM_TYPE_ADDRESSES, addrs, 6 * sizeof(uint16_t), 0, 0);
     }
+    telemetry_send_buffer(TM_PART_128, __buffer_128_start, __buffer_128_end - __buffer_128_start);
+    telemetry_send_buffer(TM_PART_256, __buffer_256_start, __buffer_256_end - __buffer_256_start);
+    telemetry_send_buffer(TM_PART_640, __buffer_640_start, __buffer_640_end - __buffer_640_start);
+    telemetry_send_stats();
 }
+#endif
 
-int a; // stack
-int b = 1; // .data
-int c = 0; // .bss
+#define STATUS_PERIOD_MS 1000
+
+#ifdef PCPROF
+#define PCPROF_STREAM_FRAMES 10 // status frames per histogram
+#endif
+
+// EEPROM keys (kv.h)
+#define KEY_BOOTS 0     // uint16_t boot counter
 
 int main(void)
 {
-    uart_init(MYUBRR);
+    uart_init(UART_BOOT_BAUD);
+    prof_init();
+    tick_init();
+#ifdef PCPROF
+    pcprof_start();
+    uint8_t pcprof_frames = 0;
+#endif
+    sei();
+    trace_boot();
     
     uint8_t sig[3];
     print_signature(sig);
 
-    fill_buffers();
+    // buffer_128/buffer_640 hold their demo pattern already: initial
+    // partition images, copied from flash at startup
+    if (pool_init() != 0) {
+        ULOG("Pool classes do not fit .buffer_256\r\n");
+    }
+    arena_frame_init();
+
+    kv_init();
+    uint16_t boots = 0;
+    kv_get(KEY_BOOTS, &boots, sizeof(boots));
+    boots++;
+    kv_set(KEY_BOOTS, &boots, sizeof(boots));
+    ULOG("Boot #%u\r\n", boots);
+
+    char cmd[32];
+    uart_line_t cmd_line;
+    uart_line_init(&cmd_line, cmd, sizeof(cmd), '\n');
 
-    uart_print("Starting main loop...\r\n");
+    ULOG("Starting main loop...\r\n");
+    trace_watchdog_enable(WDTO_4S);
+
+    // Status frames at a fixed rate; commands and the EEPROM write-back
+    // are served on every pass, and the CPU idles in between (woken at
+    // least every millisecond by the tick)
+    tick_every_t status_period;
+    tick_every_start(&status_period);
+    set_sleep_mode(SLEEP_MODE_IDLE);
 
     while (1) {
-        uprintf("Device Signature: %X %X %X\r\n", sig[0], sig[1], sig[2]);
-        uprintf("pointers:\r\n");
-        uprintf("- a=%p\r\n- b=%p\r\n- c=%p\r\n",
-            (void*)&a, (void*)&b, (void*)&c);
-        uprintf("pointers buffers:\r\n");
-        uprintf("- buffer_128=%p\r\n- buffer_256=%p\r\n- buffer_640=%p\r\n",
-                (void*)buffer_128, (void*)buffer_256, (void*)buffer_640);
-        uprintf("Buffer random values: buf128[10]=%u buf256[200]=%u buf640[500]=%u\r\n",
-                buffer_128[10], buffer_256[200], buffer_640[500]);
-        _delay_ms(1000);
+        PROF_BEGIN(PROF_LOOP);
+        if (every(&status_period, STATUS_PERIOD_MS)) {
+            PROF_BEGIN(PROF_STATUS);
+#ifdef TELEMETRY_BINARY
+            telemetry_dump(sig);
+#else
+            ULOG("Device Signature: %X %X %X\r\n", sig[0], sig[1], sig[2]);
+            ULOG("pointers:\r\n");
+            ULOG("- a=%p\r\n- b=%p\r\n- c=%p\r\n",
+                (void*)&a, (void*)&b, (void*)&c);
+            ULOG("pointers buffers:\r\n");
+            ULOG("- buffer_128=%p\r\n- pool=%p\r\n- buffer_640=%p\r\n",
+                    (void*)buffer_128, (void*)__buffer_256_start, (void*)buffer_640);
+            ULOG("Buffer random values: buf128[10]=%u buf640[100]=%u\r\n",
+                    buffer_128[10], buffer_640[100]);
+            ULOG("TX ring: pending=%u high-water=%u stalls=%u\r\n",
+                    uart_tx_pending(), uart_tx_high_water(), uart_tx_stalls());
+            ULOG("Stack: free=%u peak=%u\r\n", stack_free(), stack_peak());
+            ULOG("Uptime: %lu ms, missed frames=%u\r\n",
+                    (unsigned long)millis(), status_period.missed);
+#endif
+            PROF_END(PROF_STATUS);
+#ifdef PCPROF
+            if (++pcprof_frames == PCPROF_STREAM_FRAMES) {
+                pcprof_frames = 0;
+                pcprof_stream();
+            }
+#endif
+        }
+
+        PROF_BEGIN(PROF_CMD);
+        int cmd_len;
+        while ((cmd_len = uart_readline(&cmd_line)) != 0) {
+            trace(TRACE_EV_CMD, cmd_len > 0 ? cmd[0] : 0, cmd_len);
+            if (cmd_len < 0) {
+                ULOG("Command too long, dropped\r\n");
+            } else if (strncmp_P(cmd, PSTR("baud "), 5) == 0) {
+                uint32_t rate = strtoul(cmd + 5, NULL, 10);
+                uart_baud_t cfg;
+                uart_calc_baud(rate, &cfg);
+                if (cfg.error == UART_BAUD_INVALID) {
+                    ULOG("Unsupported baud rate, use %lu..%lu\r\n",
+                            (unsigned long)UART_BAUD_MIN, (unsigned long)UART_BAUD_MAX);
+                } else {
+                    ULOG("Switching baud: ubrr=%u u2x=%u error=%d/10000\r\n",
+                            cfg.ubrr, cfg.u2x, cfg.error);
+                    trace(TRACE_EV_BAUD, 0, rate / 100);
+                    uart_set_baud(rate);
+                }
+            } else if (strcmp_P(cmd, PSTR("pool")) == 0) {
+                pool_print_stats();
+            } else if (strcmp_P(cmd, PSTR("arena")) == 0) {
+                arena_print_stats(&arena_frame);
+            } else if (strcmp_P(cmd, PSTR("stack")) == 0) {
+                stack_print_stats();
+            } else if (strcmp_P(cmd, PSTR("kv")) == 0) {
+                kv_print_stats();
+            } else if (strcmp_P(cmd, PSTR("prof")) == 0) {
+                prof_print_stats();
+            } else if (strcmp_P(cmd, PSTR("prof reset")) == 0) {
+                prof_reset();
+#ifdef PCPROF
+            } else if (strcmp_P(cmd, PSTR("pcprof")) == 0) {
+                pcprof_stream();
+#endif
+            } else if (strcmp_P(cmd, PSTR("hang")) == 0) {
+                // Watchdog test: the trace ring is reported after the reset
+                ULOG("Hanging until the watchdog fires\r\n");
+                for (;;) {
+                }
+            } else {
+                ULOG("Command: %s\r\n", cmd);
+            }
+        }
+        PROF_END(PROF_CMD);
+        kv_poll();
+        arena_reset(&arena_frame);
+        trace_seal();
+        trace_watchdog_kick();
+        PROF_END(PROF_LOOP);
+        prof_fold();
+        sleep_mode();
     }
 
     return 0;
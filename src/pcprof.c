@@ -0,0 +1,73 @@
+#ifdef PCPROF
+
+#include "pcprof.h"
+#include "startup.h"
+#include "uart_com.h"
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+// Written by the ISR in src/pcprof_isr.S
+uint16_t pcprof_bins[PCPROF_BINS] STARTUP_DONTCARE;
+uint16_t pcprof_other;
+// Right shift from the return address (a word address) to the bin index
+uint8_t pcprof_wshift;
+
+extern const uint8_t _etext[];
+
+void pcprof_start(void)
+{
+    uint16_t top = (uint16_t)(uintptr_t)_etext - 1;
+    uint8_t shift = 2;
+
+    while ((top >> shift) >= PCPROF_BINS) {
+        shift++;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        for (uint8_t i = 0; i < PCPROF_BINS; i++) {
+            pcprof_bins[i] = 0;
+        }
+        pcprof_other = 0;
+        pcprof_wshift = shift - 1;
+    }
+    TCCR2B = 0;
+    TCCR2A = (1<<WGM21);
+    TCNT2 = 0;
+    OCR2A = PCPROF_OCR;
+    TIFR2 = (1<<OCF2A);
+    TIMSK2 = (1<<OCIE2A);
+    TCCR2B = (1<<CS22) | (1<<CS20);     // clk/128
+}
+
+void pcprof_stop(void)
+{
+    TIMSK2 = 0;
+    TCCR2B = 0;
+}
+
+void pcprof_stream(void)
+{
+    uint8_t shift = pcprof_wshift + 1;
+    uint16_t other;
+
+    uprintf_P(PSTR("PCPROF,B,%u,%u\r\n"), 1u << shift, (unsigned)PCPROF_HZ);
+    for (uint8_t i = 0; i < PCPROF_BINS; i++) {
+        uint16_t n;
+        // Read and clear together so no sample is lost or counted twice
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            n = pcprof_bins[i];
+            pcprof_bins[i] = 0;
+        }
+        if (n) {
+            uprintf_P(PSTR("PCPROF,S,%x,%u\r\n"), (uint16_t)i << shift, n);
+        }
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        other = pcprof_other;
+        pcprof_other = 0;
+    }
+    uprintf_P(PSTR("PCPROF,E,%u\r\n"), other);
+}
+
+#endif /* PCPROF */
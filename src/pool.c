@@ -0,0 +1,173 @@
+#include "pool.h"
+#include "uart_com.h"
+#include "partitions.h"
+#include "trace.h"
+
+#include <avr/pgmspace.h>
+#include <string.h>
+#include <util/atomic.h>
+
+
+typedef struct pool_block {
+    struct pool_block* next;
+} pool_block_t;
+
+typedef struct {
+    pool_block_t* free_list;
+    uint8_t* base;
+    uint8_t* end;
+    uint16_t first;             // bit of block 0 in pool_busy
+    uint16_t block_size;
+    uint8_t blocks;
+    uint8_t used;
+    uint8_t peak;
+    uint16_t failures;
+} pool_class_t;
+
+#define POOL_CLASS_INIT(size, count) { 0, 0, 0, 0, (size), (count), 0, 0, 0 },
+#define POOL_CLASS_BYTES(size, count) + (uint16_t)(size) * (count)
+#define POOL_CLASS_BLOCKS(size, count) + (count)
+#define POOL_CLASS_ONE(size, count) + 1
+
+static pool_class_t pool_classes[] = { POOL_CLASSES(POOL_CLASS_INIT) };
+
+#define POOL_NCLASSES (0 POOL_CLASSES(POOL_CLASS_ONE))
+#define POOL_TOTAL_BYTES (0 POOL_CLASSES(POOL_CLASS_BYTES))
+#define POOL_TOTAL_BLOCKS (0 POOL_CLASSES(POOL_CLASS_BLOCKS))
+
+// One bit per block, set while the block is allocated
+static uint8_t pool_busy[(POOL_TOTAL_BLOCKS + 7) / 8];
+
+_Static_assert(POOL_TOTAL_BYTES <= PARTITION_BUFFER_256_SIZE, "POOL_CLASSES exceed .buffer_256");
+
+// Bit of blk in pool_busy; blk must lie inside cls
+static uint16_t pool_bit(const pool_class_t* cls, const uint8_t* blk)
+{
+    return cls->first + (uint16_t)(blk - cls->base) / cls->block_size;
+}
+
+int8_t pool_init(void)
+{
+    uint8_t* p = __buffer_256_free;
+    uint16_t first = 0;
+
+    if ((uint16_t)(__buffer_256_end - __buffer_256_free) < POOL_TOTAL_BYTES) {
+        return -1;
+    }
+
+    for (uint8_t c = 0; c < POOL_NCLASSES; c++) {
+        pool_class_t* cls = &pool_classes[c];
+        cls->base = p;
+        cls->first = first;
+        first += cls->blocks;
+        cls->free_list = 0;
+        // Thread blocks so the lowest address is handed out first
+        p += cls->block_size * cls->blocks;
+        for (uint8_t i = cls->blocks; i > 0; i--) {
+            pool_block_t* blk = (pool_block_t*)(cls->base + (uint16_t)(i - 1) * cls->block_size);
+            blk->next = cls->free_list;
+            cls->free_list = blk;
+        }
+        cls->end = p;
+        cls->used = 0;
+        cls->peak = 0;
+        cls->failures = 0;
+    }
+    memset(pool_busy, 0, sizeof(pool_busy));
+    return 0;
+}
+
+void* pool_alloc(uint16_t size)
+{
+    for (uint8_t c = 0; c < POOL_NCLASSES; c++) {
+        pool_class_t* cls = &pool_classes[c];
+        if (cls->block_size < size) {
+            continue;
+        }
+        pool_block_t* blk = 0;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            blk = cls->free_list;
+            if (blk) {
+                uint16_t bit = pool_bit(cls, (uint8_t*)blk);
+                pool_busy[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+                cls->free_list = blk->next;
+                if (++cls->used > cls->peak) {
+                    cls->peak = cls->used;
+                }
+            } else if (cls->failures != 0xFFFF) {
+                cls->failures++;
+            }
+        }
+        if (blk) {
+            return blk;
+        }
+    }
+    trace(TRACE_EV_ALLOC, 0, size);
+    return 0;
+}
+
+void pool_free(void* block)
+{
+    uint8_t* p = (uint8_t*)block;
+
+    if (!p) {
+        return;
+    }
+    for (uint8_t c = 0; c < POOL_NCLASSES; c++) {
+        pool_class_t* cls = &pool_classes[c];
+        if (p < cls->base || p >= cls->end) {
+            continue;
+        }
+        // Not the start of a block: an offset pointer into one
+        if ((uint16_t)(p - cls->base) % cls->block_size) {
+            break;
+        }
+        uint16_t bit = pool_bit(cls, p);
+        uint8_t mask = (uint8_t)(1 << (bit & 7));
+        uint8_t ok = 0;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (pool_busy[bit >> 3] & mask) {
+                pool_busy[bit >> 3] &= (uint8_t)~mask;
+                pool_block_t* blk = (pool_block_t*)p;
+                blk->next = cls->free_list;
+                cls->free_list = blk;
+                cls->used--;
+                ok = 1;
+            }
+        }
+        if (ok) {
+            return;
+        }
+        break;
+    }
+    // Double free or a pointer pool_alloc() never returned: ignore it
+    trace(TRACE_EV_FREE, 0, (uint16_t)(uintptr_t)p);
+}
+
+uint8_t pool_class_count(void)
+{
+    return POOL_NCLASSES;
+}
+
+void pool_get_stats(uint8_t cls, pool_stats_t* out)
+{
+    const pool_class_t* pc = &pool_classes[cls];
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        out->block_size = pc->block_size;
+        out->blocks = pc->blocks;
+        out->used = pc->used;
+        out->peak = pc->peak;
+        out->failures = pc->failures;
+    }
+}
+
+void pool_print_stats(void)
+{
+    pool_stats_t st;
+
+    for (uint8_t c = 0; c < POOL_NCLASSES; c++) {
+        pool_get_stats(c, &st);
+        uprintf_P(PSTR("pool[%u] size=%u blocks=%u used=%u peak=%u fails=%u\r\n"),
+                  c, st.block_size, st.blocks, st.used, st.peak, st.failures);
+    }
+}
@@ -0,0 +1,168 @@
+#include "prof.h"
+#include "startup.h"
+#include "uart_com.h"
+
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <string.h>
+
+_Static_assert((PROF_QUEUE & (PROF_QUEUE - 1)) == 0 && PROF_QUEUE <= 128,
+               "PROF_QUEUE must be a power of two <= 128");
+
+prof_stats_t prof_table[PROF_COUNT] STARTUP_DONTCARE;
+prof_queue_t prof_queue[PROF_COUNT] STARTUP_DONTCARE;
+volatile uint16_t prof_ovf;
+
+// Span of an empty probe: from the TCNT1 read in PROF_BEGIN to the one in
+// PROF_END
+static uint8_t prof_overhead;
+
+#define PROF_NAME_(id, name) static const char id##_name[] PROGMEM = name;
+PROF_PROBES(PROF_NAME_)
+#undef PROF_NAME_
+
+#define PROF_NAME_PTR_(id, name) id##_name,
+static PGM_P const prof_names[PROF_COUNT] PROGMEM = {
+    PROF_PROBES(PROF_NAME_PTR_)
+};
+#undef PROF_NAME_PTR_
+
+ISR(TIMER1_OVF_vect)
+{
+    prof_ovf++;
+}
+
+void prof_reset(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        memset(prof_table, 0, sizeof(prof_table));
+        memset(prof_queue, 0, sizeof(prof_queue));
+        for (uint8_t i = 0; i < PROF_COUNT; i++) {
+            prof_table[i].min = UINT32_MAX;
+        }
+    }
+}
+
+void prof_init(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        TCCR1A = 0;
+        TCCR1B = 0;
+        TCNT1 = 0;
+        prof_ovf = 0;
+        TIFR1 = (1<<TOV1);
+        TIMSK1 = (1<<TOIE1);
+        TCCR1B = (1<<CS10);
+    }
+    prof_reset();
+    PROF_BEGIN(PROF_LOOP);
+    PROF_END(PROF_LOOP);
+    prof_overhead = (uint8_t)prof_queue[PROF_LOOP].span[0];
+    prof_reset();
+}
+
+// Bit length of cycles >> PROF_HIST_SHIFT, clamped to the last bucket
+static uint8_t prof_bucket(uint32_t cycles)
+{
+    uint8_t k = 0;
+
+    cycles >>= PROF_HIST_SHIFT;
+    if (cycles >> 16) {
+        return PROF_HIST_BUCKETS - 1;
+    }
+    uint16_t w = (uint16_t)cycles;
+    if (w >> 8) {
+        k = 8;
+        w >>= 8;
+    }
+    uint8_t b = (uint8_t)w;
+    while (b) {
+        k++;
+        b >>= 1;
+    }
+    return k < PROF_HIST_BUCKETS ? k : PROF_HIST_BUCKETS - 1;
+}
+
+static void prof_add(prof_stats_t* p, uint32_t cycles)
+{
+    cycles = cycles > prof_overhead ? cycles - prof_overhead : 0;
+    uint8_t k = prof_bucket(cycles);
+
+    p->count++;
+    p->sum += cycles;
+    if (cycles < p->min) {
+        p->min = cycles;
+    }
+    if (cycles > p->max) {
+        p->max = cycles;
+    }
+    if (p->hist[k] != UINT16_MAX) {
+        p->hist[k]++;
+    }
+}
+
+void prof_fold(void)
+{
+    uint32_t spans[PROF_QUEUE];
+
+    for (uint8_t i = 0; i < PROF_COUNT; i++) {
+        prof_queue_t* q = &prof_queue[i];
+        uint8_t n;
+        uint8_t lost = 0;
+
+        // Copy out under cli: the queue is short, the statistics are not
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            n = (uint8_t)(q->head - q->tail);
+            if (n > PROF_QUEUE) {
+                lost = n - PROF_QUEUE;
+                n = PROF_QUEUE;
+            }
+            for (uint8_t j = 0; j < n; j++) {
+                spans[j] = q->span[(uint8_t)(q->head - n + j) & (PROF_QUEUE - 1)];
+            }
+            q->tail = q->head;
+        }
+        prof_stats_t* p = &prof_table[i];
+        for (uint8_t j = 0; j < n; j++) {
+            prof_add(p, spans[j]);
+        }
+        // Lost spans have no duration: they stay out of count, so the
+        // average covers only the spans in sum
+        if (lost) {
+            p->lost = p->lost > UINT16_MAX - lost ? UINT16_MAX : p->lost + lost;
+        }
+    }
+}
+
+void prof_print_stats(void)
+{
+    prof_stats_t p;
+
+    prof_fold();
+    for (uint8_t i = 0; i < PROF_COUNT; i++) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            p = prof_table[i];
+        }
+        if (p.count == 0) {
+            continue;
+        }
+        // Scale both down rather than pull in a 64-bit division
+        uint64_t sum = p.sum;
+        uint32_t count = p.count;
+        while (sum > UINT32_MAX) {
+            sum >>= 1;
+            count >>= 1;
+        }
+        uint32_t avg = count ? (uint32_t)sum / count : 0;
+        uprintf_P(PSTR("prof %S n=%lu lost=%u min=%lu avg=%lu max=%lu hist"),
+                  (PGM_P)pgm_read_ptr(&prof_names[i]), (unsigned long)p.count,
+                  p.lost, (unsigned long)p.min, (unsigned long)avg, (unsigned long)p.max);
+        for (uint8_t k = 0; k < PROF_HIST_BUCKETS; k++) {
+            if (p.hist[k]) {
+                uint32_t low = k ? (uint32_t)1 << (k - 1 + PROF_HIST_SHIFT) : 0;
+                uprintf_P(PSTR(" %lu:%u"), (unsigned long)low, p.hist[k]);
+            }
+        }
+        uprintf_P(PSTR("\r\n"));
+    }
+}
@@ -0,0 +1,31 @@
+#include "stack.h"
+#include "uart_com.h"
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+extern uint8_t __noinit_end[];
+
+uint16_t stack_free(void)
+{
+    return SP - (uint16_t)(uintptr_t)__noinit_end;
+}
+
+uint16_t stack_peak(void)
+{
+    uint16_t low = (uint16_t)(uintptr_t)__noinit_end + stack_unused();
+
+    return RAMEND - low + 1;
+}
+
+void stack_print_stats(void)
+{
+    uint16_t peak = stack_peak();
+    // Margin is the never-touched canary span; derived from peak so the
+    // canary is scanned once
+    uint16_t margin = RAMEND + 1 - (uint16_t)(uintptr_t)__noinit_end - peak;
+
+    uprintf_P(PSTR("stack end=%p top=%p sp=%p free=%u peak=%u margin=%u\r\n"),
+              (void*)__noinit_end, (void*)RAMEND, (void*)SP, stack_free(),
+              peak, margin);
+}
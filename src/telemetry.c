@@ -0,0 +1,120 @@
+#include "telemetry.h"
+#include "crc16.h"
+#include "uart_com.h"
+
+static uint8_t tm_seq;
+static uint16_t tm_frames;
+
+/*
+ * A frame is a virtual concatenation of segments (for telemetry_send():
+ * header, hdr, data, crc). A cursor walks it byte by byte so COBS can look
+ * ahead for the next zero without copying the frame anywhere.
+ */
+typedef struct {
+    const tm_seg_t* seg;
+    uint8_t count;
+} tm_frame_t;
+
+typedef struct {
+    uint8_t seg;
+    uint8_t off;
+} tm_cursor_t;
+
+// Return the byte under the cursor and advance; -1 at end of frame
+static int16_t cursor_next(const tm_frame_t* f, tm_cursor_t* c)
+{
+    while (c->seg < f->count) {
+        if (c->off < f->seg[c->seg].len) {
+            return ((const uint8_t*)f->seg[c->seg].ptr)[c->off++];
+        }
+        c->seg++;
+        c->off = 0;
+    }
+    return -1;
+}
+
+void telemetry_cobs_send(const tm_seg_t* seg, uint8_t count)
+{
+    const tm_frame_t frame = { seg, count };
+    const tm_frame_t* f = &frame;
+    tm_cursor_t run = { 0, 0 };
+
+    for (;;) {
+        // Measure the run of non-zero bytes (at most 254) ahead of the cursor
+        tm_cursor_t scan = run;
+        uint8_t code = 1;
+        int16_t b;
+        while (code < 0xFF && (b = cursor_next(f, &scan)) > 0) {
+            code++;
+        }
+        uart_putc((char)code);
+        for (uint8_t i = 1; i < code; i++) {
+            uart_putc((char)cursor_next(f, &run));
+        }
+        if (code == 0xFF) {
+            // Full block without an implied zero; stop if nothing follows
+            tm_cursor_t peek = run;
+            if (cursor_next(f, &peek) < 0) {
+                break;
+            }
+            continue;
+        }
+        // Consume the zero (or reach the end) that terminated this run
+        if (cursor_next(f, &run) < 0) {
+            break;
+        }
+    }
+    uart_putc(0);
+}
+
+int8_t telemetry_send(uint8_t type, const void* hdr, uint8_t hdr_len,
+                      const void* data, uint8_t data_len)
+{
+    uint16_t payload = (uint16_t)hdr_len + data_len;
+    if (payload > TM_MAX_PAYLOAD) {
+        return -1;
+    }
+
+    uint8_t head[3] = { type, tm_seq++, (uint8_t)payload };
+    uint16_t crc = crc16_update(CRC16_INIT, head, sizeof(head));
+    crc = crc16_update(crc, hdr, hdr_len);
+    crc = crc16_update(crc, data, data_len);
+    uint8_t tail[2] = { (uint8_t)crc, (uint8_t)(crc >> 8) };
+
+    const tm_seg_t seg[4] = {
+        { head, sizeof(head) }, { hdr, hdr_len }, { data, data_len }, { tail, sizeof(tail) }
+    };
+    telemetry_cobs_send(seg, 4);
+    tm_frames++;
+    return 0;
+}
+
+void telemetry_send_buffer(uint8_t partition, const uint8_t* base, uint16_t len)
+{
+    uint16_t offset = 0;
+
+    while (offset < len) {
+        uint16_t chunk = len - offset;
+        if (chunk > TM_BUFFER_CHUNK) {
+            chunk = TM_BUFFER_CHUNK;
+        }
+        uint8_t hdr[3] = { partition, (uint8_t)offset, (uint8_t)(offset >> 8) };
+        telemetry_send(TM_TYPE_BUFFER, hdr, sizeof(hdr), base + offset, (uint8_t)chunk);
+        offset += chunk;
+    }
+}
+
+void telemetry_send_stats(void)
+{
+    uint16_t stalls = uart_tx_stalls();
+    uint16_t dropped = uart_rx_dropped();
+    uint16_t errors = uart_rx_errors();
+    uint8_t stats[10] = {
+        uart_tx_pending(), uart_tx_high_water(),
+        (uint8_t)stalls, (uint8_t)(stalls >> 8),
+        (uint8_t)dropped, (uint8_t)(dropped >> 8),
+        (uint8_t)errors, (uint8_t)(errors >> 8),
+        (uint8_t)tm_frames, (uint8_t)(tm_frames >> 8)
+    };
+    telemetry_send(TM_TYPE_STATS, stats, sizeof(stats), 0, 0);
+}
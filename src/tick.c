@@ -0,0 +1,78 @@
+#include "tick.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+_Static_assert(TICK_OCR <= 255 && (TICK_OCR + 1) * TICK_PRESCALE * 1000UL == F_CPU,
+               "F_CPU must give a whole number of Timer0 counts per millisecond");
+_Static_assert(TICK_US_PER_COUNT * F_CPU == TICK_PRESCALE * 1000000UL,
+               "F_CPU must give a whole number of microseconds per Timer0 count");
+
+static volatile uint32_t tick_ms;
+
+ISR(TIMER0_COMPA_vect)
+{
+    tick_ms++;
+}
+
+void tick_init(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        TCCR0B = 0;
+        TCCR0A = (1<<WGM01);
+        TCNT0 = 0;
+        OCR0A = TICK_OCR;
+        tick_ms = 0;
+        TIFR0 = (1<<OCF0A);
+        TIMSK0 = (1<<OCIE0A);
+        TCCR0B = (1<<CS01) | (1<<CS00);  // clk/64
+    }
+}
+
+uint32_t millis(void)
+{
+    uint32_t ms;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms = tick_ms;
+    }
+    return ms;
+}
+
+uint32_t micros(void)
+{
+    uint32_t ms;
+    uint8_t count;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms = tick_ms;
+        count = TCNT0;
+        // Matched and wrapped to 0, but the interrupt has not run yet
+        if ((TIFR0 & (1<<OCF0A)) && count < TICK_OCR / 2) {
+            ms++;
+        }
+    }
+    return ms * 1000 + (uint16_t)count * TICK_US_PER_COUNT;
+}
+
+void tick_every_start(tick_every_t* e)
+{
+    e->next = millis();
+    e->missed = 0;
+}
+
+uint8_t every(tick_every_t* e, uint16_t period_ms)
+{
+    uint32_t now = millis();
+
+    if ((int32_t)(now - e->next) < 0) {
+        return 0;
+    }
+    e->next += period_ms;
+    while ((int32_t)(now - e->next) >= 0) {
+        e->next += period_ms;
+        e->missed++;
+    }
+    return 1;
+}
@@ -0,0 +1,120 @@
+#include "trace.h"
+#include "crc16.h"
+#include "uart_com.h"
+#include "telemetry.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+#include <stddef.h>
+
+_Static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0 && TRACE_RING_SIZE <= 128,
+               "TRACE_RING_SIZE must be a power of two <= 128");
+
+// Neither is touched by the C runtime, so both keep their value across
+// resets. trace_reset_cause is written from .init3 by src/trace_init.S.
+trace_ring_t trace_ring __attribute__((section(".noinit")));
+uint8_t trace_reset_cause __attribute__((section(".noinit")));
+
+static uint16_t trace_crc(void)
+{
+    uint16_t crc = crc16_update(CRC16_INIT, &trace_ring, offsetof(trace_ring_t, crc));
+    return crc16_update(crc, trace_ring.rec, sizeof(trace_ring.rec));
+}
+
+void trace_seal(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        // Nothing written since the last seal: the CRC still matches
+        if (!trace_ring.sealed) {
+            trace_ring.sealed = 1;
+            trace_ring.crc = trace_crc();
+        }
+    }
+}
+
+static uint8_t trace_check(void)
+{
+    if (trace_ring.magic != TRACE_MAGIC || trace_ring.count > TRACE_RING_SIZE
+        || trace_ring.head >= TRACE_RING_SIZE) {
+        return TRACE_INVALID;
+    }
+    if (!trace_ring.sealed) {
+        return TRACE_UNSEALED;
+    }
+    return trace_ring.crc == trace_crc() ? TRACE_SEALED : TRACE_INVALID;
+}
+
+static void trace_print(uint8_t state)
+{
+    uint8_t cause = trace_reset_cause;
+
+    uprintf_P(PSTR("Reset cause: 0x%x%S%S%S%S\r\n"), cause,
+              (cause & _BV(PORF)) ? PSTR(" power-on") : PSTR(""),
+              (cause & _BV(EXTRF)) ? PSTR(" external") : PSTR(""),
+              (cause & _BV(BORF)) ? PSTR(" brown-out") : PSTR(""),
+              (cause & _BV(WDRF)) ? PSTR(" watchdog") : PSTR(""));
+    if (state == TRACE_INVALID) {
+        uart_print_P(PSTR("Trace: no valid ring\r\n"));
+        return;
+    }
+    uprintf_P(PSTR("Trace: %S, %u records, %u boots\r\n"),
+              state == TRACE_SEALED ? PSTR("sealed") : PSTR("unsealed"),
+              trace_ring.count, trace_ring.boots);
+    // Oldest first
+    uint8_t i = (trace_ring.head - trace_ring.count) & (TRACE_RING_SIZE - 1);
+    for (uint8_t n = 0; n < trace_ring.count; n++) {
+        const trace_rec_t* r = &trace_ring.rec[i];
+        uprintf_P(PSTR("- id=%u arg8=%u arg16=%u\r\n"), r->id, r->arg8, r->arg16);
+        i = (i + 1) & (TRACE_RING_SIZE - 1);
+    }
+}
+
+uint8_t trace_boot(void)
+{
+    uint8_t state = trace_check();
+    uint8_t boots = 0;
+
+#ifdef TELEMETRY_BINARY
+    // [cause][state][head][count][boots] + the raw ring; the host reorders
+    uint8_t hdr[5] = { trace_reset_cause, state, trace_ring.head, trace_ring.count, trace_ring.boots };
+    telemetry_send(TM_TYPE_TRACE, hdr, sizeof(hdr),
+                   state == TRACE_INVALID ? 0 : trace_ring.rec,
+                   state == TRACE_INVALID ? 0 : sizeof(trace_ring.rec));
+#else
+    trace_print(state);
+#endif
+    if (state != TRACE_INVALID) {
+        boots = trace_ring.boots + 1;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        trace_ring.magic = TRACE_MAGIC;
+        trace_ring.head = 0;
+        trace_ring.count = 0;
+        trace_ring.boots = boots;
+    }
+    trace(TRACE_EV_BOOT, trace_reset_cause, 0);
+    trace_seal();
+    return state;
+}
+
+void trace_watchdog_enable(uint8_t timeout)
+{
+    uint8_t wdp = (timeout & 0x07) | ((timeout & 0x08) ? _BV(WDP3) : 0);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        wdt_reset();
+        WDTCSR = _BV(WDCE) | _BV(WDE);
+        WDTCSR = _BV(WDIE) | _BV(WDE) | wdp;
+    }
+}
+
+// First timeout: the hardware clears WDIE, so the next one resets the MCU.
+// Leave WDIE clear so the reset is not postponed, just make the ring
+// verifiable. If the stall ends in time, trace_watchdog_kick() re-arms it.
+ISR(WDT_vect)
+{
+    trace(TRACE_EV_WDT, 0, 0);
+    trace_seal();
+}
@@ -1,140 +1,560 @@
 #include "uart_com.h"
+#include "fmt_num.h"
+#include "blk.h"
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
 #include <util/delay.h>
 #include <avr/boot.h>
 #include <string.h>
 #include <stdarg.h>
 
-void uart_init(unsigned int ubrr)
+#define UART_TX_MASK (UART_TX_RING_SIZE - 1)
+
+_Static_assert(UART_TX_RING_SIZE <= 256 && (UART_TX_RING_SIZE & UART_TX_MASK) == 0,
+               "UART_TX_RING_SIZE must be a power of two <= 256");
+
+// TX ring storage: carved from the .buffer_640 partition (NOLOAD, never cleared)
+#ifdef BUFFER_SECTION_ATTRIBUTE
+static uint8_t tx_ring[UART_TX_RING_SIZE] __attribute__((section(".buffer_640.uart_tx")));
+#else
+static uint8_t tx_ring[UART_TX_RING_SIZE];
+#endif
+
+#define UART_RX_MASK (UART_RX_RING_SIZE - 1)
+
+_Static_assert(UART_RX_RING_SIZE <= 128 && (UART_RX_RING_SIZE & UART_RX_MASK) == 0,
+               "UART_RX_RING_SIZE must be a power of two <= 128");
+
+// RX ring storage: carved from the .buffer_128 partition
+#ifdef BUFFER_SECTION_ATTRIBUTE
+static uint8_t rx_ring[UART_RX_RING_SIZE] __attribute__((section(".buffer_128.uart_rx")));
+#else
+static uint8_t rx_ring[UART_RX_RING_SIZE];
+#endif
+
+static volatile uint8_t rx_head;    // next free slot, written by the ISR only
+static volatile uint8_t rx_tail;    // next byte to read, written by the reader only
+static volatile uint16_t rx_dropped;
+static volatile uint16_t rx_errors;
+
+static volatile uint8_t tx_head;    // next free slot, written by producers only
+static volatile uint8_t tx_tail;    // next byte to send, written by the ISR only
+static volatile uint8_t tx_active;  // a byte was loaded into UDR0 since the last flush
+static uint8_t tx_high_water;
+static uint16_t tx_stalls;
+
+void uart_init(uint32_t baud)
 {
-    // Set baud rate
-    UBRR0H = (unsigned char)(ubrr>>8);
-    UBRR0L = (unsigned char)ubrr;
-    // Enable transmitter
-    UCSR0B = (1<<TXEN0);
+    uart_set_baud(baud);
+    // Enable receiver with its interrupt, and the transmitter
+    // (UDRIE0 is only set while the TX ring holds data)
+    UCSR0B = (1<<RXEN0) | (1<<RXCIE0) | (1<<TXEN0);
     // Set frame format: 8 data bits, 1 stop bit
     UCSR0C = (1<<UCSZ01) | (1<<UCSZ00);
 }
 
-static void uart_transmit(unsigned char data)
+// Evaluate one prescaler mode (divisor 16 or 8): nearest UBRR and its error
+static uint16_t baud_ubrr(uint32_t baud, uint8_t divisor, int16_t* error)
+{
+    uint32_t scaled = (uint32_t)divisor * baud;
+    uint32_t ubrr = (F_CPU + scaled / 2) / scaled;
+
+    if (ubrr == 0) {
+        ubrr = 1;
+    }
+    if (ubrr > 4096) {
+        ubrr = 4096;
+    }
+    uint32_t actual = F_CPU / ((uint32_t)divisor * ubrr);
+    // |diff| <= UART_BAUD_MAX, so diff * 10000 would overflow: divide in
+    // two steps of 100, each product stays below 2^31
+    int32_t diff = (int32_t)(actual - baud);
+    int32_t hundreds = diff * 100;
+    int32_t err = hundreds / (int32_t)baud * 100 + hundreds % (int32_t)baud * 100 / (int32_t)baud;
+    if (err > INT16_MAX) {
+        err = INT16_MAX;
+    }
+    if (err < -INT16_MAX) {
+        err = -INT16_MAX;
+    }
+    *error = (int16_t)err;
+    return (uint16_t)(ubrr - 1);
+}
+
+void uart_calc_baud(uint32_t baud, uart_baud_t* out)
+{
+    int16_t err_normal;
+    int16_t err_double;
+
+    if (baud < UART_BAUD_MIN || baud > UART_BAUD_MAX) {
+        out->ubrr = 0;
+        out->u2x = 0;
+        out->error = UART_BAUD_INVALID;
+        return;
+    }
+    uint16_t ubrr_normal = baud_ubrr(baud, 16, &err_normal);
+    uint16_t ubrr_double = baud_ubrr(baud, 8, &err_double);
+
+    int16_t abs_normal = err_normal < 0 ? -err_normal : err_normal;
+    int16_t abs_double = err_double < 0 ? -err_double : err_double;
+
+    if (abs_double < abs_normal) {
+        out->ubrr = ubrr_double;
+        out->u2x = 1;
+        out->error = err_double;
+    } else {
+        out->ubrr = ubrr_normal;
+        out->u2x = 0;
+        out->error = err_normal;
+    }
+}
+
+int16_t uart_set_baud(uint32_t baud)
+{
+    uart_baud_t cfg;
+
+    uart_calc_baud(baud, &cfg);
+    if (cfg.error == UART_BAUD_INVALID) {
+        return UART_BAUD_INVALID;
+    }
+
+    // Let queued bytes leave at the old rate before reprogramming
+    uart_flush();
+
+    UBRR0H = (unsigned char)(cfg.ubrr>>8);
+    UBRR0L = (unsigned char)cfg.ubrr;
+    // Writing 0 to the flag bits is harmless; only U2X0 is meaningful here
+    UCSR0A = cfg.u2x ? (1<<U2X0) : 0;
+    return cfg.error;
+}
+
+uint32_t uart_get_baud(void)
+{
+    uint16_t ubrr = ((uint16_t)UBRR0H << 8) | UBRR0L;
+    uint8_t divisor = (UCSR0A & (1<<U2X0)) ? 8 : 16;
+    return F_CPU / ((uint32_t)divisor * (ubrr + 1));
+}
+
+static inline uint8_t tx_used(void)
+{
+    return (uint8_t)(tx_head - tx_tail) & UART_TX_MASK;
+}
+
+// Move the byte at the ring tail into UDR0. Caller guarantees the ring is
+// not empty and UDR0 is free.
+static inline void tx_send_one(void)
+{
+    uint8_t tail = tx_tail;
+    // Clear TXC0 (write-one-to-clear) so uart_flush() can wait for this
+    // byte. Write back only U2X0/MPCM0: a read-modify-write would also
+    // write 1 to a set FE0/DOR0/UPE0, which must be written as 0
+    UCSR0A = (UCSR0A & ((1<<U2X0)|(1<<MPCM0))) | (1<<TXC0);
+    UDR0 = tx_ring[tail];
+    tx_active = 1;
+    tail = (tail + 1) & UART_TX_MASK;
+    tx_tail = tail;
+    if (tail == tx_head) {
+        UCSR0B &= ~(1<<UDRIE0);
+    }
+}
+
+ISR(USART_UDRE_vect)
+{
+    if (tx_tail == tx_head) {
+        UCSR0B &= ~(1<<UDRIE0);
+        return;
+    }
+    tx_send_one();
+}
+
+// Wait for one slot to free up. With interrupts disabled the ISR cannot run,
+// so push a byte out by polling instead of deadlocking.
+static void tx_wait_space(void)
+{
+    if (tx_stalls != 0xFFFF) {
+        tx_stalls++;
+    }
+    while (((uint8_t)(tx_tail - tx_head - 1) & UART_TX_MASK) == 0) {
+        if (!(SREG & (1<<SREG_I))) {
+            while (!(UCSR0A & (1<<UDRE0)));
+            tx_send_one();
+        }
+    }
+}
+
+void uart_write(const void* data, uint16_t len)
 {
-    // Wait for empty transmit buffer
-    while (!(UCSR0A & (1<<UDRE0)));
-    // Put data into buffer, sends the data
-    UDR0 = data;
+    const uint8_t* src = (const uint8_t*)data;
+
+    while (len) {
+        uint8_t head = tx_head;
+        uint16_t chunk = (uint8_t)(tx_tail - head - 1) & UART_TX_MASK;
+        if (chunk == 0) {
+            tx_wait_space();
+            continue;
+        }
+        // Copy the largest contiguous span before the ring wraps
+        if (chunk > (uint16_t)(UART_TX_RING_SIZE - head)) {
+            chunk = UART_TX_RING_SIZE - head;
+        }
+        if (chunk > len) {
+            chunk = len;
+        }
+        blk_copy(&tx_ring[head], src, chunk);
+        src += chunk;
+        len -= chunk;
+        tx_head = (head + chunk) & UART_TX_MASK;
+        // Publish after the head update; the ISR clears UDRIE0 once empty
+        UCSR0B |= (1<<UDRIE0);
+
+        uint8_t used = tx_used();
+        if (used > tx_high_water) {
+            tx_high_water = used;
+        }
+    }
+}
+
+void uart_putc(char c)
+{
+    uint8_t head = tx_head;
+    uint8_t next = (head + 1) & UART_TX_MASK;
+    if (next == tx_tail) {
+        tx_wait_space();
+    }
+    tx_ring[head] = (uint8_t)c;
+    tx_head = next;
+    UCSR0B |= (1<<UDRIE0);
+
+    uint8_t used = tx_used();
+    if (used > tx_high_water) {
+        tx_high_water = used;
+    }
 }
 
 void uart_print(const char* str)
 {
-    while (*str) {
-        uart_transmit(*str++);
+    uart_write(str, strlen(str));
+}
+
+void uart_print_P(const char* str)
+{
+    char c;
+    while ((c = (char)pgm_read_byte(str++)) != '\0') {
+        uart_putc(c);
     }
 }
 
-int uprintf(const char* format, ...)
+void uart_flush(void)
 {
-    char buffer[128]; // Use stack-based buffer instead of heap
-    va_list args;
-    va_start(args, format);
-    
-    int buf_idx = 0;
+    while (tx_tail != tx_head) {
+        if (!(SREG & (1<<SREG_I)) && (UCSR0A & (1<<UDRE0))) {
+            tx_send_one();
+        }
+    }
+    if (tx_active) {
+        // Wait for the last byte to leave the shift register
+        while (!(UCSR0A & (1<<TXC0)));
+        tx_active = 0;
+    }
+}
+
+uint8_t uart_tx_pending(void)
+{
+    return tx_used();
+}
+
+uint8_t uart_tx_high_water(void)
+{
+    return tx_high_water;
+}
+
+uint16_t uart_tx_stalls(void)
+{
+    return tx_stalls;
+}
+
+void uart_tx_stats_reset(void)
+{
+    tx_high_water = tx_used();
+    tx_stalls = 0;
+}
+
+ISR(USART_RX_vect)
+{
+    // Error flags are only valid before UDR0 is read
+    uint8_t status = UCSR0A;
+    uint8_t data = UDR0;
+
+    if (status & ((1<<FE0) | (1<<DOR0) | (1<<UPE0))) {
+        if (rx_errors != 0xFFFF) {
+            rx_errors++;
+        }
+        if (status & ((1<<FE0) | (1<<UPE0))) {
+            return;
+        }
+    }
+
+    uint8_t head = rx_head;
+    uint8_t next = (head + 1) & UART_RX_MASK;
+    if (next == rx_tail) {
+        if (rx_dropped != 0xFFFF) {
+            rx_dropped++;
+        }
+        return;
+    }
+    rx_ring[head] = data;
+    rx_head = next;
+}
+
+int uart_getc(void)
+{
+    uint8_t tail = rx_tail;
+    if (tail == rx_head) {
+        return -1;
+    }
+    uint8_t data = rx_ring[tail];
+    rx_tail = (tail + 1) & UART_RX_MASK;
+    return data;
+}
+
+uint8_t uart_read(uint8_t* buf, uint8_t max)
+{
+    uint8_t tail = rx_tail;
+    uint8_t head = rx_head;
+    uint8_t count = 0;
+
+    while (tail != head && count < max) {
+        buf[count++] = rx_ring[tail];
+        tail = (tail + 1) & UART_RX_MASK;
+    }
+    rx_tail = tail;
+    return count;
+}
+
+uint8_t uart_rx_available(void)
+{
+    return (uint8_t)(rx_head - rx_tail) & UART_RX_MASK;
+}
+
+uint16_t uart_rx_dropped(void)
+{
+    uint16_t val;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        val = rx_dropped;
+    }
+    return val;
+}
+
+uint16_t uart_rx_errors(void)
+{
+    uint16_t val;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        val = rx_errors;
+    }
+    return val;
+}
+
+void uart_line_init(uart_line_t* line, char* buf, uint8_t size, char delim)
+{
+    line->buf = buf;
+    line->size = size;
+    line->len = 0;
+    line->delim = delim;
+    line->overflow = 0;
+}
+
+int uart_readline(uart_line_t* line)
+{
+    int c;
+
+    while ((c = uart_getc()) >= 0) {
+        if ((char)c == line->delim) {
+            uint8_t len = line->len;
+            line->len = 0;
+            if (line->overflow) {
+                line->overflow = 0;
+                return -1;
+            }
+            if (line->delim == '\n' && len > 0 && line->buf[len - 1] == '\r') {
+                len--;
+            }
+            line->buf[len] = '\0';
+            return len;
+        }
+        if (line->len + 1 < line->size) {
+            line->buf[line->len++] = (char)c;
+        } else {
+            // Keep consuming until the delimiter so the next record starts clean
+            line->overflow = 1;
+        }
+    }
+    return 0;
+}
+
+static int emit_chars(uprintf_sink_t sink, void* ctx, const char* temp, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++) {
+        sink(ctx, temp[i]);
+    }
+    return n;
+}
+
+// Read one format character from SRAM or, for the _P variants, from flash
+#define FMT_READ(p) (flash_fmt ? (char)pgm_read_byte(p) : *(p))
+
+static int format_core(uprintf_sink_t sink, void* ctx, const char* format,
+                       uint8_t flash_fmt, va_list args)
+{
+    int count = 0;
     const char* p = format;
-    
-    while (*p && buf_idx < 127) {
-        if (*p == '%') {
+    char ch;
+
+    while ((ch = FMT_READ(p)) != '\0') {
+        if (ch != '%') {
+            sink(ctx, ch);
             p++;
-            if (*p == 'd' || *p == 'i') {
-                // Integer
-                int val = va_arg(args, int);
-                int is_negative = val < 0;
-                if (is_negative) val = -val;
-                
-                // Convert to string (reverse order)
-                char temp[12];
-                int temp_idx = 0;
-                if (val == 0) {
-                    temp[temp_idx++] = '0';
-                } else {
-                    while (val > 0) {
-                        temp[temp_idx++] = '0' + (val % 10);
-                        val /= 10;
-                    }
-                }
-                if (is_negative) temp[temp_idx++] = '-';
-                
-                // Copy reversed
-                while (temp_idx > 0 && buf_idx < 127) {
-                    buffer[buf_idx++] = temp[--temp_idx];
-                }
-            } else if (*p == 'u') {
-                // Unsigned integer
-                unsigned int val = va_arg(args, unsigned int);
-                char temp[12];
-                int temp_idx = 0;
-                if (val == 0) {
-                    temp[temp_idx++] = '0';
-                } else {
-                    while (val > 0) {
-                        temp[temp_idx++] = '0' + (val % 10);
-                        val /= 10;
-                    }
-                }
-                while (temp_idx > 0 && buf_idx < 127) {
-                    buffer[buf_idx++] = temp[--temp_idx];
-                }
-            } else if (*p == 'x' || *p == 'X') {
-                // Hexadecimal
-                unsigned int val = va_arg(args, unsigned int);
-                const char* hex_digits = (*p == 'X') ? "0123456789ABCDEF" : "0123456789abcdef";
-                char temp[9];
-                int temp_idx = 0;
-                if (val == 0) {
-                    temp[temp_idx++] = '0';
-                } else {
-                    while (val > 0) {
-                        temp[temp_idx++] = hex_digits[val & 0xF];
-                        val >>= 4;
-                    }
-                }
-                while (temp_idx > 0 && buf_idx < 127) {
-                    buffer[buf_idx++] = temp[--temp_idx];
-                }
-            } else if (*p == 's') {
-                // String
-                const char* str = va_arg(args, const char*);
-                while (*str && buf_idx < 127) {
-                    buffer[buf_idx++] = *str++;
-                }
-            } else if (*p == 'c') {
-                // Character
-                buffer[buf_idx++] = (char)va_arg(args, int);
-            } else if (*p == 'p') {
-                // Pointer - format as 0x000000 (6 hex digits with leading zeros)
-                void* ptr = va_arg(args, void*);
-                unsigned int val = (unsigned int)ptr;
-                buffer[buf_idx++] = '0';
-                buffer[buf_idx++] = 'x';
-                
-                // Print 6 hex digits with leading zeros (for 16-bit addresses)
-                for (int i = 5; i >= 0; i--) {
-                    unsigned int nibble = (val >> (i * 4)) & 0xF;
-                    buffer[buf_idx++] = "0123456789abcdef"[nibble];
-                    if (buf_idx >= 127) break;
-                }
-            } else if (*p == '%') {
-                // Literal %
-                buffer[buf_idx++] = '%';
-            }
+            count++;
+            continue;
+        }
+        p++;
+        ch = FMT_READ(p);
+        // 'l' selects 32-bit long arguments for d/i/u/x/X
+        uint8_t is_long = 0;
+        if (ch == 'l') {
+            is_long = 1;
             p++;
-        } else {
-            buffer[buf_idx++] = *p++;
+            ch = FMT_READ(p);
+        }
+        char temp[FMT_NUM_MAX_DIGITS];
+        if (ch == 'd' || ch == 'i') {
+            // Integer: the kernels work on the magnitude, so INT_MIN is safe
+            uint8_t n = is_long ? fmt_i32(temp, (int32_t)va_arg(args, long))
+                                : fmt_int(temp, va_arg(args, int));
+            count += emit_chars(sink, ctx, temp, n);
+        } else if (ch == 'u') {
+            // Unsigned integer
+            uint8_t n = is_long ? fmt_u32(temp, va_arg(args, unsigned long))
+                                : fmt_uint(temp, va_arg(args, unsigned int));
+            count += emit_chars(sink, ctx, temp, n);
+        } else if (ch == 'x' || ch == 'X') {
+            // Hexadecimal
+            unsigned long val = is_long ? va_arg(args, unsigned long)
+                                        : va_arg(args, unsigned int);
+            count += emit_chars(sink, ctx, temp, fmt_hex32(temp, (uint32_t)val, ch == 'X'));
+        } else if (ch == 's') {
+            // String
+            const char* str = va_arg(args, const char*);
+            while (*str) {
+                sink(ctx, *str++);
+                count++;
+            }
+        } else if (ch == 'S') {
+            // String stored in flash (PROGMEM / PSTR)
+            const char* str = va_arg(args, const char*);
+            char c;
+            while ((c = (char)pgm_read_byte(str++)) != '\0') {
+                sink(ctx, c);
+                count++;
+            }
+        } else if (ch == 'c') {
+            // Character
+            sink(ctx, (char)va_arg(args, int));
+            count++;
+        } else if (ch == 'p') {
+            // Pointer - format as 0x000000 (6 hex digits with leading zeros)
+            void* ptr = va_arg(args, void*);
+            unsigned long val = (unsigned long)(uintptr_t)ptr;
+            sink(ctx, '0');
+            sink(ctx, 'x');
+            for (int i = 5; i >= 0; i--) {
+                sink(ctx, "0123456789abcdef"[(val >> (i * 4)) & 0xF]);
+            }
+            count += 8;
+        } else if (ch == '%') {
+            // Literal %
+            sink(ctx, '%');
+            count++;
+        } else if (ch == '\0') {
+            // Lone '%' at the end of the format
+            break;
         }
+        p++;
     }
-    
-    buffer[buf_idx] = '\0';
+    return count;
+}
+
+int uvfprintf(uprintf_sink_t sink, void* ctx, const char* format, va_list args)
+{
+    return format_core(sink, ctx, format, 0, args);
+}
+
+int uvfprintf_P(uprintf_sink_t sink, void* ctx, const char* format, va_list args)
+{
+    return format_core(sink, ctx, format, 1, args);
+}
+
+int ufprintf(uprintf_sink_t sink, void* ctx, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int count = uvfprintf(sink, ctx, format, args);
     va_end(args);
-    
-    uart_print(buffer);
-    return buf_idx;
+    return count;
+}
+
+// noinline, used: --icall uart_sink in the stack-depth check needs the
+// symbol in the image even under LTO
+static __attribute__((noinline, used)) void uart_sink(void* ctx, char c)
+{
+    (void)ctx;
+    uart_putc(c);
+}
+
+int uprintf(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int count = uvfprintf(uart_sink, 0, format, args);
+    va_end(args);
+    return count;
+}
+
+int uprintf_P(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int count = format_core(uart_sink, 0, format, 1, args);
+    va_end(args);
+    return count;
+}
+
+typedef struct {
+    char* buf;
+    size_t size;
+    size_t len;
+} buffer_sink_t;
+
+// noinline, used: see uart_sink
+static __attribute__((noinline, used)) void buffer_sink(void* ctx, char c)
+{
+    buffer_sink_t* out = (buffer_sink_t*)ctx;
+    if (out->len + 1 < out->size) {
+        out->buf[out->len++] = c;
+    }
+}
+
+int usnprintf(char* buf, size_t size, const char* format, ...)
+{
+    buffer_sink_t out = { buf, size, 0 };
+    va_list args;
+    va_start(args, format);
+    int count = uvfprintf(buffer_sink, &out, format, args);
+    va_end(args);
+    if (size > 0) {
+        buf[out.len] = '\0';
+    }
+    return count;
 }
@@ -0,0 +1,42 @@
+#include "ulog.h"
+#include "crc16.h"
+#include "telemetry.h"
+
+#include <string.h>
+
+#ifdef ULOG_DEFERRED
+
+void ulog_send(uint16_t id, const ulog_arg_t* args, uint8_t count)
+{
+    // id, a length byte and the characters per string argument, crc
+    tm_seg_t seg[1 + 2 * ULOG_MAX_ARGS + 1];
+    uint8_t str_len[ULOG_MAX_ARGS];
+    uint8_t n = 0;
+
+    // AVR is little-endian, which is what the host decoder expects
+    seg[n++] = (tm_seg_t){ &id, sizeof(id) };
+    for (uint8_t i = 0; i < count; i++) {
+        if (args[i].kind == 's') {
+            const char* str = *(const char* const*)args[i].value;
+            size_t len = strlen(str);
+            str_len[i] = len > 255 ? 255 : (uint8_t)len;
+            seg[n++] = (tm_seg_t){ &str_len[i], 1 };
+            seg[n++] = (tm_seg_t){ str, str_len[i] };
+        } else {
+            seg[n++] = (tm_seg_t){ args[i].value, (uint8_t)(args[i].kind - '0') };
+        }
+    }
+
+    uint16_t crc = CRC16_INIT;
+    for (uint8_t i = 0; i < n; i++) {
+        crc = crc16_update(crc, seg[i].ptr, seg[i].len);
+    }
+    uint8_t tail[2] = { (uint8_t)crc, (uint8_t)(crc >> 8) };
+    seg[n++] = (tm_seg_t){ tail, sizeof(tail) };
+
+    // Leading delimiter: ends any plain text sent since the last record
+    uart_putc(0);
+    telemetry_cobs_send(seg, n);
+}
+
+#endif /* ULOG_DEFERRED */
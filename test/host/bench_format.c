@@ -0,0 +1,105 @@
+/*
+ * Host microbenchmarks of the formatting core: the uprintf_bench.c and
+ * fmt_num_bench.c cases, compiled with the host compiler and timed with
+ * clock_gettime(). Run with make host-bench.
+ *
+ * The nanoseconds say nothing about AVR cycles, but the ratios between
+ * cases and between two versions of uart_com.c / fmt_num.c usually hold:
+ * a change that is not faster here is rarely faster on the target. Confirm
+ * with make bench before keeping it.
+ *
+ * The output lines are BENCH_HOST <name> <ns per call>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <avr/pgmspace.h>
+#include "uart_com.h"
+#include "fmt_num.h"
+
+#define BENCH_HOST_NS 50000000ULL   // time each case for about 50 ms
+
+// Opaque to the optimizer, like the volatile sinks of the AVR benchmarks
+static volatile int val_int = -12345;
+static volatile unsigned int val_uint = 54321;
+static volatile long val_long = -1234567890L;
+static volatile unsigned long val_ulong = 4000000000UL;
+static volatile uint16_t val_u16 = 65535;
+static volatile uint32_t val_u32 = 123456789UL;
+static const char* volatile val_str = "telemetry";
+static volatile uint8_t sink_byte;
+
+static char out[64];
+static uint8_t sig[3] = { 0x1E, 0x95, 0x0F };
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void null_sink(void* ctx, char c)
+{
+    (void)ctx;
+    sink_byte = (uint8_t)c;
+}
+
+// Calibrate the iteration count on a short run, then time the real one
+#define BENCH_HOST(name, stmt) do {                                     \
+        uint64_t iters_ = 1;                                            \
+        uint64_t t_;                                                    \
+        for (;;) {                                                      \
+            t_ = now_ns();                                              \
+            for (uint64_t i_ = 0; i_ < iters_; i_++) {                  \
+                stmt;                                                   \
+            }                                                           \
+            t_ = now_ns() - t_;                                         \
+            if (t_ >= BENCH_HOST_NS / 10) {                             \
+                break;                                                  \
+            }                                                           \
+            iters_ *= 4;                                                \
+        }                                                               \
+        iters_ = iters_ * BENCH_HOST_NS / (t_ ? t_ : 1) + 1;            \
+        t_ = now_ns();                                                  \
+        for (uint64_t i_ = 0; i_ < iters_; i_++) {                      \
+            stmt;                                                       \
+        }                                                               \
+        t_ = now_ns() - t_;                                             \
+        mock_uart_clear();                                              \
+        printf("BENCH_HOST %s %.1f\n", (name), (double)t_ / (double)iters_); \
+    } while (0)
+
+int main(void)
+{
+    uart_init(UART_BOOT_BAUD);
+
+    // uprintf goes through the TX path into the mock UDR0
+    BENCH_HOST("uart_print_16", uart_print("0123456789abcdef"));
+    BENCH_HOST("uprintf_literal_16", uprintf("0123456789abcdef"));
+    BENCH_HOST("uprintf_P_literal_16", uprintf_P(PSTR("0123456789abcdef")));
+    BENCH_HOST("uprintf_d", uprintf("%d", val_int));
+    BENCH_HOST("uprintf_lu", uprintf("%lu", val_ulong));
+
+    // The formatter alone: a sink that only stores the byte
+    BENCH_HOST("ufprintf_d", ufprintf(null_sink, NULL, "%d", val_int));
+    BENCH_HOST("ufprintf_u", ufprintf(null_sink, NULL, "%u", val_uint));
+    BENCH_HOST("ufprintf_x", ufprintf(null_sink, NULL, "%x", val_uint));
+    BENCH_HOST("ufprintf_ld", ufprintf(null_sink, NULL, "%ld", val_long));
+    BENCH_HOST("ufprintf_lu", ufprintf(null_sink, NULL, "%lu", val_ulong));
+    BENCH_HOST("ufprintf_lx", ufprintf(null_sink, NULL, "%lx", val_ulong));
+    BENCH_HOST("ufprintf_s", ufprintf(null_sink, NULL, "%s", val_str));
+    BENCH_HOST("usnprintf_status_line",
+               usnprintf(out, sizeof(out), "sig=%X %X %X count=%u up=%lu\r\n",
+                         sig[0], sig[1], sig[2], val_uint, val_ulong));
+
+    // Number conversion below the formatter
+    BENCH_HOST("u16_fmt[65535]", sink_byte = (uint8_t)out[fmt_u16(out, val_u16) - 1]);
+    BENCH_HOST("u32_fmt[123456789]", sink_byte = (uint8_t)out[fmt_u32(out, val_u32) - 1]);
+    BENCH_HOST("i32_fmt", sink_byte = (uint8_t)out[fmt_i32(out, (int32_t)val_long) - 1]);
+    BENCH_HOST("hex32_fmt", sink_byte = (uint8_t)out[fmt_hex32(out, (uint32_t)val_ulong, 1) - 1]);
+
+    return 0;
+}
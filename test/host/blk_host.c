@@ -0,0 +1,49 @@
+// Portable C versions of the src/blk.S kernels for the host build
+
+#include "blk.h"
+
+#include <string.h>
+
+void blk_fill(void* dst, uint8_t value, uint16_t n)
+{
+    memset(dst, value, n);
+}
+
+void blk_fill_pattern(void* dst, uint16_t pattern, uint16_t n)
+{
+    uint8_t* d = (uint8_t*)dst;
+    for (uint16_t i = 0; i < n; i++) {
+        d[i] = (i & 1) ? pattern >> 8 : pattern & 0xFF;
+    }
+}
+
+void blk_copy(void* dst, const void* src, uint16_t n)
+{
+    memcpy(dst, src, n);
+}
+
+void blk_move(void* dst, const void* src, uint16_t n)
+{
+    memmove(dst, src, n);
+}
+
+int blk_compare(const void* a, const void* b, uint16_t n)
+{
+    const uint8_t* pa = (const uint8_t*)a;
+    const uint8_t* pb = (const uint8_t*)b;
+    for (uint16_t i = 0; i < n; i++) {
+        if (pa[i] != pb[i]) {
+            return pa[i] - pb[i];
+        }
+    }
+    return 0;
+}
+
+void blk_xor(void* dst, const void* src, uint16_t n)
+{
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    for (uint16_t i = 0; i < n; i++) {
+        d[i] ^= s[i];
+    }
+}
@@ -0,0 +1,332 @@
+/*
+ * libFuzzer harness for the uprintf formatter (src/uart_com.c on the host).
+ *
+ *     make host-fuzz                  # clang -fsanitize=fuzzer,address,undefined
+ *
+ * Input: a format string up to the first NUL byte (at most FUZZ_MAX_FMT
+ * bytes), then a pool of argument bytes. The format is split the way
+ * format_core() parses it, into pieces holding at most one conversion;
+ * each piece is printed with an argument of the type its conversion reads,
+ * taken from the pool, so the varargs are always well-typed. Formats whose
+ * conversions all read int (or all read long) are also printed in one
+ * call, to cover va_list advancement.
+ *
+ * Checks, besides the sanitizers:
+ * - usnprintf(), uprintf() (captured from UDR0) and uprintf_P() agree,
+ *   and each returns the length of its output
+ * - a truncated usnprintf() is a terminated prefix of the full output
+ * - %d %i %u %x %X %c %s %S %% and their l forms match the host snprintf()
+ *
+ * Built with -DFUZZ_STANDALONE (make host-fuzz-smoke, no clang needed) it
+ * gets a main() that replays the files given on the command line, or runs
+ * pseudo-random inputs when there are none.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <avr/pgmspace.h>
+#include "uart_com.h"
+
+#define FUZZ_MAX_FMT 128
+#define FUZZ_MAX_STR 16
+#define FUZZ_OUT 2048
+
+typedef enum { ARG_NONE, ARG_INT, ARG_LONG, ARG_STR, ARG_PTR } arg_kind_t;
+
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+    size_t pos;
+} pool_t;
+
+static uint32_t pool_take(pool_t* p, uint8_t bytes)
+{
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < bytes; i++) {
+        v |= (uint32_t)(p->pos < p->len ? p->data[p->pos++] : 0) << (8 * i);
+    }
+    return v;
+}
+
+// NUL-free string of up to FUZZ_MAX_STR bytes
+static void pool_str(pool_t* p, char* out)
+{
+    uint8_t n = (uint8_t)pool_take(p, 1) % (FUZZ_MAX_STR + 1);
+    uint8_t i = 0;
+    while (i < n && p->pos < p->len) {
+        char c = (char)p->data[p->pos++];
+        out[i++] = c ? c : '0';
+    }
+    out[i] = '\0';
+}
+
+// Argument kind of the conversion at fmt[pos] (just past a '%'); sets
+// *end to the index after it, like format_core() advances
+static arg_kind_t conversion(const char* fmt, size_t pos, size_t* end, char* conv, int* is_long)
+{
+    *is_long = fmt[pos] == 'l';
+    if (*is_long) {
+        pos++;
+    }
+    *conv = fmt[pos];
+    *end = fmt[pos] ? pos + 1 : pos;
+    switch (*conv) {
+    case 'd': case 'i': case 'u': case 'x': case 'X':
+        return *is_long ? ARG_LONG : ARG_INT;
+    case 'c':
+        return ARG_INT;
+    case 's': case 'S':
+        return ARG_STR;
+    case 'p':
+        return ARG_PTR;
+    default:
+        return ARG_NONE;
+    }
+}
+
+// Conversions whose output the host snprintf() defines the same way
+static int reference_applies(char conv, int is_long)
+{
+    if (conv == '\0') {
+        return 0;
+    }
+    return strchr("diuxX", conv) != NULL || (!is_long && strchr("%csS", conv) != NULL);
+}
+
+static void fail(const char* what, const char* fmt, const char* got, const char* expect)
+{
+    fprintf(stderr, "fuzz_uprintf: %s\n  format: \"%s\"\n  got:    \"%s\"\n  expect: \"%s\"\n",
+            what, fmt, got, expect ? expect : "");
+    abort();
+}
+
+// Print fmt through every entry point with the same arguments and
+// cross-check; ref is the host snprintf() result or NULL
+#define CHECK_ALL(fmt, ref, ...) do {                                   \
+        char out_[FUZZ_OUT];                                            \
+        char cut_[8];                                                   \
+        int n_ = usnprintf(out_, sizeof(out_), (fmt), __VA_ARGS__);     \
+        if (n_ < 0 || (size_t)n_ >= sizeof(out_) || strlen(out_) != (size_t)n_) \
+            fail("usnprintf length", (fmt), out_, NULL);                \
+        int c_ = usnprintf(cut_, sizeof(cut_), (fmt), __VA_ARGS__);     \
+        if (c_ != n_ || strncmp(cut_, out_, sizeof(cut_) - 1) != 0      \
+            || strlen(cut_) != (size_t)(n_ < 7 ? n_ : 7))               \
+            fail("truncated usnprintf", (fmt), cut_, out_);             \
+        mock_uart_clear();                                              \
+        int u_ = uprintf((fmt), __VA_ARGS__);                           \
+        uart_flush();                                                   \
+        if (u_ != n_ || mock_uart.tx_len != (size_t)n_                  \
+            || memcmp(mock_uart.tx, out_, n_) != 0)                     \
+            fail("uprintf differs from usnprintf", (fmt), (const char*)mock_uart.tx, out_); \
+        mock_uart_clear();                                              \
+        int p_ = uprintf_P((fmt), __VA_ARGS__);                         \
+        uart_flush();                                                   \
+        if (p_ != n_ || memcmp(mock_uart.tx, out_, n_) != 0)            \
+            fail("uprintf_P differs from usnprintf", (fmt), (const char*)mock_uart.tx, out_); \
+        const char* ref_ = (ref);                                       \
+        if (ref_ != NULL && strcmp(out_, ref_) != 0)                    \
+            fail("differs from snprintf", (fmt), out_, ref_);           \
+    } while (0)
+
+#define REFERENCE(ok, fmt, ...) \
+    ((ok) ? (snprintf(ref_buf, sizeof(ref_buf), (fmt), __VA_ARGS__), ref_buf) : NULL)
+
+static char ref_buf[FUZZ_OUT];
+
+// The host long is 64 bits; the reference prints the 32-bit values as int
+// with the l modifiers removed
+static char* strip_long(const char* fmt)
+{
+    static char out[FUZZ_MAX_FMT + 1];
+    size_t n = 0;
+
+    while (*fmt != '\0') {
+        char c = *fmt++;
+        out[n++] = c;
+        if (c == '%') {
+            if (*fmt == 'l') {
+                fmt++;
+            }
+            if (*fmt != '\0') {
+                out[n++] = *fmt++;
+            }
+        }
+    }
+    out[n] = '\0';
+    return out;
+}
+
+// %c of a zero byte would end the output string early
+static int char_arg(int v)
+{
+    return (v & 0xFF) ? v : v | 1;
+}
+
+static void check_piece(char* piece, arg_kind_t kind, char conv, int ref_ok, pool_t* pool)
+{
+    char str[FUZZ_MAX_STR + 1];
+
+    switch (kind) {
+    case ARG_INT: {
+        int v = (int)pool_take(pool, 4);
+        if (conv == 'c') {
+            v = char_arg(v);
+        }
+        CHECK_ALL(piece, REFERENCE(ref_ok, piece, v), v);
+        break;
+    }
+    case ARG_LONG: {
+        // The formatter prints longs as 32 bits, as on the target
+        int32_t v = (int32_t)pool_take(pool, 4);
+        CHECK_ALL(piece, REFERENCE(ref_ok, strip_long(piece), (int)v), (long)v);
+        break;
+    }
+    case ARG_STR: {
+        pool_str(pool, str);
+        // %S reads flash, which on the host is the same memory as %s
+        char* ref = NULL;
+        if (ref_ok) {
+            char* c = strrchr(piece, conv);
+            *c = 's';
+            snprintf(ref_buf, sizeof(ref_buf), piece, str);
+            *c = conv;
+            ref = ref_buf;
+        }
+        CHECK_ALL(piece, ref, str);
+        break;
+    }
+    case ARG_PTR: {
+        void* v = (void*)(uintptr_t)pool_take(pool, 3);
+        CHECK_ALL(piece, NULL, v);
+        break;
+    }
+    default:
+        CHECK_ALL(piece, REFERENCE(ref_ok, piece, 0), 0);
+        break;
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    char fmt[FUZZ_MAX_FMT + 1];
+    size_t fmt_len = 0;
+
+    while (fmt_len < size && fmt_len < FUZZ_MAX_FMT && data[fmt_len] != 0) {
+        fmt[fmt_len] = (char)data[fmt_len];
+        fmt_len++;
+    }
+    fmt[fmt_len] = '\0';
+    pool_t pool = { data + fmt_len, size - fmt_len, 0 };
+
+    static int ready;
+    if (!ready) {
+        uart_init(UART_BOOT_BAUD);
+        ready = 1;
+    }
+
+    // One conversion per piece
+    size_t start = 0;
+    size_t pos = 0;
+    int all_int = 1;
+    int all_long = 1;
+    int ref_whole = 1;
+    int convs = 0;
+    int has_char = 0;
+    while (fmt[pos] != '\0') {
+        if (fmt[pos] != '%') {
+            pos++;
+            continue;
+        }
+        size_t end;
+        char conv;
+        int is_long;
+        arg_kind_t kind = conversion(fmt, pos + 1, &end, &conv, &is_long);
+        char piece[FUZZ_MAX_FMT + 1];
+        memcpy(piece, fmt + start, end - start);
+        piece[end - start] = '\0';
+        // The literal text before the conversion has no '%' in it
+        check_piece(piece, kind, conv, reference_applies(conv, is_long), &pool);
+
+        has_char |= conv == 'c';
+        all_int &= kind == ARG_INT || kind == ARG_NONE;
+        all_long &= kind == ARG_LONG || kind == ARG_NONE;
+        ref_whole &= reference_applies(conv, is_long);
+        convs += kind != ARG_NONE;
+        start = pos = end;
+    }
+    if (fmt[start] != '\0') {
+        CHECK_ALL(fmt + start, REFERENCE(1, "%s", fmt + start), 0);
+    }
+
+    // Whole format in one call when every argument has the same type
+    if (convs <= 6 && (all_int || all_long)) {
+        if (all_int) {
+            int a[6];
+            for (int i = 0; i < 6; i++) {
+                a[i] = (int)pool_take(&pool, 4);
+                if (has_char) {
+                    a[i] = char_arg(a[i]);
+                }
+            }
+            CHECK_ALL(fmt, REFERENCE(ref_whole, fmt, a[0], a[1], a[2], a[3], a[4], a[5]),
+                      a[0], a[1], a[2], a[3], a[4], a[5]);
+        } else {
+            int32_t a[6];
+            for (int i = 0; i < 6; i++) {
+                a[i] = (int32_t)pool_take(&pool, 4);
+            }
+            CHECK_ALL(fmt, REFERENCE(ref_whole, strip_long(fmt), (int)a[0], (int)a[1], (int)a[2],
+                                     (int)a[3], (int)a[4], (int)a[5]),
+                      (long)a[0], (long)a[1], (long)a[2], (long)a[3], (long)a[4], (long)a[5]);
+        }
+    }
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+
+static const char fuzz_alphabet[] = "%%%%dilusSxXcp lqz09-\n";
+
+int main(int argc, char** argv)
+{
+    uint8_t buf[512];
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            FILE* f = fopen(argv[i], "rb");
+            if (!f) {
+                perror(argv[i]);
+                return 1;
+            }
+            size_t n = fread(buf, 1, sizeof(buf), f);
+            fclose(f);
+            LLVMFuzzerTestOneInput(buf, n);
+        }
+        printf("fuzz_uprintf: %d inputs ok\n", argc - 1);
+        return 0;
+    }
+
+    // No corpus: formats biased towards conversions, random argument bytes
+    srand(1);
+    for (int iter = 0; iter < 200000; iter++) {
+        size_t fmt_len = (size_t)rand() % 24;
+        size_t n = 0;
+        for (; n < fmt_len; n++) {
+            buf[n] = (rand() % 4) ? (uint8_t)fuzz_alphabet[rand() % (sizeof(fuzz_alphabet) - 1)]
+                                  : (uint8_t)(rand() % 255 + 1);
+        }
+        buf[n++] = 0;
+        size_t pool = (size_t)rand() % 64;
+        for (size_t i = 0; i < pool; i++) {
+            buf[n++] = (uint8_t)rand();
+        }
+        LLVMFuzzerTestOneInput(buf, n);
+    }
+    printf("fuzz_uprintf: 200000 random inputs ok\n");
+    return 0;
+}
+
+#endif /* FUZZ_STANDALONE */
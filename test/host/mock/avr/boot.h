@@ -0,0 +1,6 @@
+#ifndef MOCK_AVR_BOOT_H
+#define MOCK_AVR_BOOT_H
+
+// Nothing in the host build reads fuses or signature bytes
+
+#endif /* MOCK_AVR_BOOT_H */
@@ -0,0 +1,15 @@
+#ifndef MOCK_AVR_INTERRUPT_H
+#define MOCK_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+// Vectors become plain functions the tests call to simulate the interrupt
+#define ISR(vector, ...) void vector(void); void vector(void)
+
+void USART_RX_vect(void);
+void USART_UDRE_vect(void);
+
+#define sei() (SREG |= (1 << SREG_I))
+#define cli() (SREG &= (uint8_t)~(1 << SREG_I))
+
+#endif /* MOCK_AVR_INTERRUPT_H */
@@ -0,0 +1,101 @@
+#ifndef MOCK_AVR_IO_H
+#define MOCK_AVR_IO_H
+
+/*
+ * Host stand-in for <avr/io.h>: the USART0 registers uart_com.c uses, plus
+ * WDTCSR for trace.h and the Timer1 registers prof.c uses.
+ *
+ * UDR0 and UCSR0A are function-backed lvalues (see mock_avr.c):
+ * - Every access to UDR0 outside a simulated receive is a transmit and
+ *   appends one byte to mock_uart.tx, so the capture holds exactly what
+ *   went out on the wire. During mock_uart_receive(), UDR0 reads the
+ *   injected byte instead.
+ * - UCSR0A always reads with UDRE0 and TXC0 set (an infinitely fast
+ *   transmitter), plus the injected error flags during a receive.
+ *
+ * The other registers are plain variables. SREG starts with the I flag
+ * clear, so uart_com.c drains the TX ring by polling instead of waiting
+ * for an interrupt that never comes.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MOCK_UART_TX_CAPTURE 4096
+
+typedef struct {
+    uint8_t tx[MOCK_UART_TX_CAPTURE];
+    size_t tx_len;              // bytes written to UDR0 (capped at the capture)
+    size_t tx_total;            // including those past the capture
+    uint8_t rx_active;          // inside mock_uart_receive()
+    uint8_t rx_byte;
+    uint8_t rx_status;          // FE0/DOR0/UPE0 for the byte being received
+    uint8_t scratch;            // target of UDR0 writes past the capture
+    uint8_t ucsr0a;
+} mock_uart_t;
+
+extern mock_uart_t mock_uart;
+extern uint8_t UCSR0B;
+extern uint8_t UCSR0C;
+extern uint8_t UBRR0H;
+extern uint8_t UBRR0L;
+extern uint8_t SREG;
+extern uint8_t WDTCSR;
+extern uint8_t TCCR1A;
+extern uint8_t TCCR1B;
+extern uint8_t TIMSK1;
+extern uint8_t TIFR1;
+extern uint16_t TCNT1;
+
+volatile uint8_t* mock_udr0(void);
+volatile uint8_t* mock_ucsr0a(void);
+
+/**
+ * Forget captured TX bytes
+ */
+void mock_uart_clear(void);
+
+/**
+ * Run the RX-complete interrupt for one byte, with error flags in status
+ */
+void mock_uart_receive(uint8_t byte, uint8_t status);
+
+#define UDR0 (*mock_udr0())
+#define UCSR0A (*mock_ucsr0a())
+
+// UCSR0A
+#define RXC0 7
+#define TXC0 6
+#define UDRE0 5
+#define FE0 4
+#define DOR0 3
+#define UPE0 2
+#define U2X0 1
+#define MPCM0 0
+
+// UCSR0B
+#define RXCIE0 7
+#define TXCIE0 6
+#define UDRIE0 5
+#define RXEN0 4
+#define TXEN0 3
+#define UCSZ02 2
+
+// UCSR0C
+#define UCSZ01 2
+#define UCSZ00 1
+
+#define SREG_I 7
+
+// WDTCSR (trace.h kicks the watchdog)
+#define WDIF 7
+#define WDIE 6
+
+// Timer1 (prof.c's cycle clock; TCNT1 only moves when a test sets it)
+#define CS10 0
+#define TOIE1 0
+#define TOV1 0
+
+#define _BV(bit) (1 << (bit))
+
+#endif /* MOCK_AVR_IO_H */
@@ -0,0 +1,18 @@
+#ifndef MOCK_AVR_PGMSPACE_H
+#define MOCK_AVR_PGMSPACE_H
+
+// One address space on the host: flash reads are plain loads
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define pgm_read_ptr(p) (*(const void* const*)(p))
+#define memcpy_P(dst, src, n) memcpy((dst), (src), (n))
+
+#endif /* MOCK_AVR_PGMSPACE_H */
@@ -0,0 +1,8 @@
+#ifndef MOCK_AVR_WDT_H
+#define MOCK_AVR_WDT_H
+
+// No watchdog on the host
+
+#define wdt_reset() ((void)0)
+
+#endif /* MOCK_AVR_WDT_H */
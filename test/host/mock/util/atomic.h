@@ -0,0 +1,10 @@
+#ifndef MOCK_UTIL_ATOMIC_H
+#define MOCK_UTIL_ATOMIC_H
+
+// Single-threaded host: the block simply runs once
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 1
+#define ATOMIC_BLOCK(type) for (int mock_atomic_once_ = 1; mock_atomic_once_; mock_atomic_once_ = 0)
+
+#endif /* MOCK_UTIL_ATOMIC_H */
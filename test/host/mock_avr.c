@@ -0,0 +1,54 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+
+mock_uart_t mock_uart;
+uint8_t UCSR0B;
+uint8_t UCSR0C;
+uint8_t UBRR0H;
+uint8_t UBRR0L;
+uint8_t SREG;
+uint8_t WDTCSR;
+uint8_t TCCR1A;
+uint8_t TCCR1B;
+uint8_t TIMSK1;
+uint8_t TIFR1;
+uint16_t TCNT1;
+
+volatile uint8_t* mock_udr0(void)
+{
+    if (mock_uart.rx_active) {
+        return &mock_uart.rx_byte;
+    }
+    mock_uart.tx_total++;
+    if (mock_uart.tx_len < MOCK_UART_TX_CAPTURE) {
+        return &mock_uart.tx[mock_uart.tx_len++];
+    }
+    return &mock_uart.scratch;
+}
+
+volatile uint8_t* mock_ucsr0a(void)
+{
+    // Keep U2X0/MPCM0 as written; the transmitter is always ready
+    mock_uart.ucsr0a &= (1<<U2X0) | (1<<MPCM0);
+    mock_uart.ucsr0a |= (1<<UDRE0) | (1<<TXC0);
+    if (mock_uart.rx_active) {
+        mock_uart.ucsr0a |= (1<<RXC0) | mock_uart.rx_status;
+    }
+    return &mock_uart.ucsr0a;
+}
+
+void mock_uart_clear(void)
+{
+    mock_uart.tx_len = 0;
+    mock_uart.tx_total = 0;
+}
+
+void mock_uart_receive(uint8_t byte, uint8_t status)
+{
+    mock_uart.rx_active = 1;
+    mock_uart.rx_byte = byte;
+    mock_uart.rx_status = status;
+    USART_RX_vect();
+    mock_uart.rx_active = 0;
+}
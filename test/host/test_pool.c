@@ -0,0 +1,152 @@
+/*
+ * Host unit tests for src/pool.c, compiled unchanged against the mock in
+ * test/host/mock. Run with make host-test.
+ *
+ * The linker symbols that bound the pool are aliased onto a host array,
+ * and trace_ring is defined here so rejected frees can be checked.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "partitions.h"
+#include "pool.h"
+#include "trace.h"
+
+static int checks;
+static int failures;
+
+#define CHECK(cond) do {                                                \
+        checks++;                                                       \
+        if (!(cond)) {                                                  \
+            failures++;                                                 \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                               \
+    } while (0)
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+
+// Stand-in for .buffer_256: [__buffer_256_free, __buffer_256_end) is all of it
+uint8_t mock_buffer_256[PARTITION_BUFFER_256_SIZE];
+__asm__(".globl __buffer_256_free\n"
+        ".set __buffer_256_free, mock_buffer_256\n"
+        ".globl __buffer_256_end\n"
+        ".set __buffer_256_end, mock_buffer_256 + " STR(PARTITION_BUFFER_256_SIZE) "\n");
+
+trace_ring_t trace_ring;
+
+static uint8_t* alloc(uint16_t size)
+{
+    return (uint8_t*)pool_alloc(size);
+}
+
+static pool_stats_t stats(uint8_t cls)
+{
+    pool_stats_t st;
+
+    pool_get_stats(cls, &st);
+    return st;
+}
+
+static int in_pool(const uint8_t* p)
+{
+    return p >= mock_buffer_256 && p < mock_buffer_256 + sizeof(mock_buffer_256);
+}
+
+// The last trace record is a rejected free of p
+static int traced_free(const void* p)
+{
+    const trace_rec_t* r = &trace_ring.rec[(trace_ring.head - 1) & (TRACE_RING_SIZE - 1)];
+
+    return trace_ring.count > 0 && r->id == TRACE_EV_FREE
+        && r->arg16 == (uint16_t)(uintptr_t)p;
+}
+
+static void test_alloc(void)
+{
+    uint8_t* small[8];
+    uint8_t* p;
+
+    CHECK(pool_init() == 0);
+    CHECK(pool_class_count() == 3);
+
+    // Lowest address first, each block inside the partition
+    for (int i = 0; i < 8; i++) {
+        small[i] = alloc(1 + i);
+        CHECK(in_pool(small[i]));
+        CHECK(i == 0 || small[i] == small[i - 1] + 16);
+    }
+    CHECK(stats(0).used == 8);
+    CHECK(stats(0).peak == 8);
+
+    // Class 0 exhausted: small requests spill into the next class up
+    p = alloc(16);
+    CHECK(in_pool(p) && p >= small[7] + 16);
+    CHECK(stats(0).failures == 1);
+    CHECK(stats(1).used == 1);
+    CHECK(alloc(32) != 0);
+    CHECK(alloc(64) != 0);
+    CHECK(stats(2).used == 1);
+
+    // Everything out
+    CHECK(alloc(1) == 0);
+    CHECK(alloc(65) == 0);
+    CHECK(stats(2).failures == 1);
+
+    // A freed block is handed out again
+    pool_free(small[3]);
+    CHECK(stats(0).used == 7);
+    CHECK(stats(0).peak == 8);
+    CHECK(alloc(16) == small[3]);
+}
+
+static void test_bad_free(void)
+{
+    uint8_t* a;
+    uint8_t* b;
+    uint8_t local;
+
+    CHECK(pool_init() == 0);
+    a = alloc(16);
+    b = alloc(16);
+
+    // Double free: the second one changes nothing
+    pool_free(a);
+    CHECK(stats(0).used == 1);
+    trace_ring.count = 0;
+    pool_free(a);
+    CHECK(stats(0).used == 1);
+    CHECK(traced_free(a));
+
+    // The free list was not corrupted: a comes back once, then fresh blocks
+    CHECK(alloc(16) == a);
+    CHECK(alloc(16) == b + 16);
+    CHECK(stats(0).used == 3);
+
+    // Offset, never-allocated and foreign pointers are rejected
+    pool_free(b + 1);
+    CHECK(traced_free(b + 1));
+    pool_free(b + 32);
+    CHECK(traced_free(b + 32));
+    pool_free(&local);
+    CHECK(traced_free(&local));
+    CHECK(stats(0).used == 3);
+
+    // NULL is ignored without a trace record
+    trace_ring.count = 0;
+    pool_free(0);
+    CHECK(trace_ring.count == 0);
+
+    pool_free(b);
+    CHECK(stats(0).used == 2);
+}
+
+int main(void)
+{
+    test_alloc();
+    test_bad_free();
+
+    printf("%d checks, %d failures\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Host unit tests for src/prof.c, compiled unchanged against the register
+ * mock in test/host/mock. Run with make host-test.
+ *
+ * TCNT1 stands still, so the empty-probe calibration is 0 and spans queued
+ * with prof_push() reach the statistics unchanged.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "prof.h"
+#include "uart_com.h"
+
+static int checks;
+static int failures;
+
+#define CHECK(cond) do {                                                \
+        checks++;                                                       \
+        if (!(cond)) {                                                  \
+            failures++;                                                 \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                               \
+    } while (0)
+
+// Run prof_print_stats() and compare what it sent with expect
+static void check_print(int line, const char* expect)
+{
+    mock_uart_clear();
+    prof_print_stats();
+    uart_flush();
+    checks++;
+    if (mock_uart.tx_len != strlen(expect) || memcmp(mock_uart.tx, expect, mock_uart.tx_len) != 0) {
+        failures++;
+        printf("%s:%d: printed \"%.*s\", expected \"%s\"\n", __FILE__, line,
+               (int)mock_uart.tx_len, (const char*)mock_uart.tx, expect);
+    }
+}
+
+static void test_fold(void)
+{
+    const prof_stats_t* p = &prof_table[PROF_CMD];
+
+    prof_reset();
+    prof_push(PROF_CMD, 100);
+    prof_push(PROF_CMD, 300);
+    CHECK(p->count == 0);
+    prof_fold();
+    CHECK(p->count == 2);
+    CHECK(p->lost == 0);
+    CHECK(p->sum == 400);
+    CHECK(p->min == 100);
+    CHECK(p->max == 300);
+    // A second fold finds the queue empty
+    prof_fold();
+    CHECK(p->count == 2);
+    check_print(__LINE__, "prof cmd n=2 lost=0 min=100 avg=200 max=300 hist 64:1 256:1\r\n");
+}
+
+static void test_overflow(void)
+{
+    const prof_stats_t* p = &prof_table[PROF_LOOP];
+
+    // PROF_QUEUE + 2 spans between folds: the two oldest are overwritten
+    prof_reset();
+    for (uint32_t i = 1; i <= PROF_QUEUE + 2; i++) {
+        prof_push(PROF_LOOP, i * 1000);
+    }
+    prof_fold();
+    CHECK(p->count == PROF_QUEUE);
+    CHECK(p->lost == 2);
+    CHECK(p->min == 3000);
+    CHECK(p->max == (PROF_QUEUE + 2) * 1000UL);
+    // The average covers the folded spans only, not the lost ones
+    CHECK(p->sum / p->count == (3000 + (PROF_QUEUE + 2) * 1000UL) / 2);
+
+    // Wrapped head/tail still count correctly
+    prof_reset();
+    for (uint16_t i = 0; i < 300; i++) {
+        prof_push(PROF_LOOP, 50);
+        if (i % 2) {
+            prof_fold();
+        }
+    }
+    CHECK(p->count == 300);
+    CHECK(p->lost == 0);
+}
+
+static void test_print(void)
+{
+    prof_reset();
+    check_print(__LINE__, "");
+    for (uint8_t i = 0; i < PROF_QUEUE + 3; i++) {
+        prof_push(PROF_KV_ISR, 40);
+    }
+    check_print(__LINE__, "prof kv_isr n=4 lost=3 min=40 avg=40 max=40 hist 32:4\r\n");
+}
+
+int main(void)
+{
+    uart_init(UART_BOOT_BAUD);
+    prof_init();
+
+    test_fold();
+    test_overflow();
+    test_print();
+
+    printf("%d checks, %d failures\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * Host unit tests for src/uart_com.c, compiled unchanged against the
+ * register mock in test/host/mock. Run with make host-test.
+ *
+ * Interrupts stay disabled (SREG I clear), so every write drains through
+ * the polling path and lands in mock_uart.tx.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+#include <avr/pgmspace.h>
+#include "uart_com.h"
+
+static int checks;
+static int failures;
+
+#define CHECK(cond) do {                                                \
+        checks++;                                                       \
+        if (!(cond)) {                                                  \
+            failures++;                                                 \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                               \
+    } while (0)
+
+// Run stmt and compare everything it sent with expect
+#define CHECK_TX(expect, stmt) do {                                     \
+        mock_uart_clear();                                              \
+        stmt;                                                           \
+        uart_flush();                                                   \
+        check_tx(__FILE__, __LINE__, (expect), sizeof(expect) - 1);     \
+    } while (0)
+
+static void check_tx(const char* file, int line, const char* expect, size_t len)
+{
+    checks++;
+    if (mock_uart.tx_len != len || memcmp(mock_uart.tx, expect, len) != 0) {
+        failures++;
+        printf("%s:%d: sent \"%.*s\" (%zu bytes), expected \"%s\"\n", file, line,
+               (int)mock_uart.tx_len, (const char*)mock_uart.tx, mock_uart.tx_len, expect);
+    }
+}
+
+static void test_integers(void)
+{
+    CHECK_TX("0 -1 32767 -32768", uprintf("%d %i %d %d", 0, -1, 32767, -32768));
+    CHECK_TX("65535 0", uprintf("%u %u", 65535u, 0u));
+    CHECK_TX("beef BEEF 0", uprintf("%x %X %x", 0xbeefu, 0xbeefu, 0u));
+    CHECK_TX("-2147483648 2147483647",
+             uprintf("%ld %li", (long)INT32_MIN, (long)INT32_MAX));
+    CHECK_TX("4294967295 deadbeef DEADBEEF",
+             uprintf("%lu %lx %lX", (unsigned long)UINT32_MAX,
+                     (unsigned long)0xdeadbeefUL, (unsigned long)0xdeadbeefUL));
+}
+
+static void test_text(void)
+{
+    static const char flash[] PROGMEM = "flash";
+
+    CHECK_TX("a=Z s=ram S=flash %", uprintf("a=%c s=%s S=%S %%", 'Z', "ram", flash));
+    CHECK_TX("", uprintf(""));
+    CHECK_TX("empty=[]", uprintf("empty=[%s]", ""));
+    CHECK_TX("p=0x001234", uprintf("p=%p", (void*)(uintptr_t)0x1234));
+    // Unknown conversions print nothing; a lone trailing '%' ends the format
+    CHECK_TX("ab", uprintf("a%qb"));
+    CHECK_TX("end", uprintf("end%"));
+    CHECK_TX("P 42", uprintf_P(PSTR("P %u"), 42u));
+}
+
+static void test_counts(void)
+{
+    int n;
+
+    CHECK_TX("x=-12345!", n = uprintf("x=%d!", -12345));
+    CHECK(n == 9);
+    CHECK_TX("0x000000", n = uprintf("%p", (void*)0));
+    CHECK(n == 8);
+    CHECK_TX("flash", n = uprintf_P(PSTR("%S"), PSTR("flash")));
+    CHECK(n == 5);
+}
+
+static void test_snprintf(void)
+{
+    char buf[8];
+
+    CHECK(usnprintf(buf, sizeof(buf), "%u-%u", 12u, 34u) == 5);
+    CHECK(strcmp(buf, "12-34") == 0);
+    // Truncated to size-1, terminated, full length returned
+    CHECK(usnprintf(buf, sizeof(buf), "%lu", (unsigned long)4000000000UL) == 10);
+    CHECK(strcmp(buf, "4000000") == 0);
+    memset(buf, 'x', sizeof(buf));
+    CHECK(usnprintf(buf, 0, "abc") == 3);
+    CHECK(buf[0] == 'x');
+    CHECK(usnprintf(buf, 1, "abc") == 3);
+    CHECK(buf[0] == '\0');
+}
+
+typedef struct {
+    char text[16];
+    int len;
+} sink_buf_t;
+
+static void test_sink(void* ctx, char c)
+{
+    sink_buf_t* s = (sink_buf_t*)ctx;
+    s->text[s->len++] = c;
+}
+
+static void test_custom_sink(void)
+{
+    sink_buf_t s = { { 0 }, 0 };
+
+    mock_uart_clear();
+    CHECK(ufprintf(test_sink, &s, "<%X>", 0xabu) == 4);
+    CHECK(s.len == 4 && memcmp(s.text, "<AB>", 4) == 0);
+    CHECK(mock_uart.tx_total == 0);
+}
+
+static void test_tx_ring(void)
+{
+    char big[3 * UART_TX_RING_SIZE + 7];
+
+    for (size_t i = 0; i < sizeof(big); i++) {
+        big[i] = (char)('a' + i % 26);
+    }
+    uart_tx_stats_reset();
+    mock_uart_clear();
+    // More than the ring holds: the writer stalls and drains by polling
+    uart_write(big, sizeof(big));
+    CHECK(uart_tx_high_water() == UART_TX_RING_SIZE - 1);
+    CHECK(uart_tx_stalls() > 0);
+    uart_flush();
+    CHECK(uart_tx_pending() == 0);
+    CHECK(mock_uart.tx_len == sizeof(big));
+    CHECK(memcmp(mock_uart.tx, big, sizeof(big)) == 0);
+
+    uart_tx_stats_reset();
+    CHECK(uart_tx_high_water() == 0 && uart_tx_stalls() == 0);
+    CHECK_TX("ok\r\n", uart_print("ok"); uart_putc('\r'); uart_putc('\n'));
+    CHECK_TX("flash", uart_print_P(PSTR("flash")));
+}
+
+static void test_rx(void)
+{
+    uint8_t buf[8];
+    uint16_t dropped = uart_rx_dropped();
+    uint16_t errors = uart_rx_errors();
+
+    CHECK(uart_getc() == -1);
+    mock_uart_receive('h', 0);
+    mock_uart_receive('i', 0);
+    CHECK(uart_rx_available() == 2);
+    CHECK(uart_getc() == 'h');
+    CHECK(uart_read(buf, sizeof(buf)) == 1 && buf[0] == 'i');
+
+    // Framing/parity errors drop the byte; an overrun keeps it
+    mock_uart_receive('x', 1<<FE0);
+    mock_uart_receive('y', 1<<UPE0);
+    mock_uart_receive('z', 1<<DOR0);
+    CHECK(uart_rx_errors() == errors + 3);
+    CHECK(uart_getc() == 'z');
+    CHECK(uart_getc() == -1);
+
+    // The ring keeps UART_RX_RING_SIZE - 1 bytes, the rest is counted
+    for (int i = 0; i < UART_RX_RING_SIZE + 4; i++) {
+        mock_uart_receive((uint8_t)i, 0);
+    }
+    CHECK(uart_rx_available() == UART_RX_RING_SIZE - 1);
+    CHECK(uart_rx_dropped() == dropped + 5);
+    while (uart_getc() >= 0) {
+    }
+}
+
+static void receive_str(const char* s, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        mock_uart_receive((uint8_t)s[i], 0);
+    }
+}
+
+static void test_readline(void)
+{
+    char buf[8];
+    uart_line_t line;
+
+    uart_line_init(&line, buf, sizeof(buf), '\n');
+    receive_str("baud", 4);
+    CHECK(uart_readline(&line) == 0);
+    receive_str(" 9\r\n", 4);
+    CHECK(uart_readline(&line) == 6);
+    CHECK(strcmp(buf, "baud 9") == 0);
+
+    // Too long for buf: discarded as a whole, the next line is clean
+    receive_str("0123456789\nok\n", 14);
+    CHECK(uart_readline(&line) == -1);
+    CHECK(uart_readline(&line) == 2);
+    CHECK(strcmp(buf, "ok") == 0);
+
+    // Zero-delimited packets keep a trailing '\r'
+    uart_line_init(&line, buf, sizeof(buf), '\0');
+    receive_str("a\r\0", 3);
+    CHECK(uart_readline(&line) == 2);
+    CHECK(memcmp(buf, "a\r", 3) == 0);
+}
+
+static void test_baud(void)
+{
+    uart_baud_t cfg;
+
+    uart_calc_baud(9600, &cfg);
+    CHECK(cfg.ubrr == 103 && cfg.u2x == 0 && cfg.error == 15);
+    // 115200 is 2.1 % off in double speed but -3.5 % in normal mode
+    uart_calc_baud(115200, &cfg);
+    CHECK(cfg.ubrr == 16 && cfg.u2x == 1 && cfg.error == 212);
+    uart_calc_baud(1000000, &cfg);
+    CHECK(cfg.ubrr == 0 && cfg.u2x == 0 && cfg.error == 0);
+    // Far from any divisor: large errors, but no overflow
+    uart_calc_baud(1500000, &cfg);
+    CHECK(cfg.ubrr == 0 && cfg.u2x == 0 && cfg.error == -3333);
+    uart_calc_baud(UART_BAUD_MAX, &cfg);
+    CHECK(cfg.ubrr == 0 && cfg.u2x == 1 && cfg.error == 0);
+    uart_calc_baud(UART_BAUD_MIN, &cfg);
+    CHECK(cfg.ubrr == 4095 && cfg.u2x == 0 && cfg.error == 0);
+    // Out of the generator's range
+    uart_calc_baud(4000000, &cfg);
+    CHECK(cfg.error == UART_BAUD_INVALID);
+    uart_calc_baud(UART_BAUD_MIN - 1, &cfg);
+    CHECK(cfg.error == UART_BAUD_INVALID);
+
+    CHECK(uart_set_baud(115200) == 212);
+    CHECK(uart_get_baud() == 117647);
+    CHECK(uart_set_baud(0) == UART_BAUD_INVALID);
+    CHECK(uart_set_baud(4000000) == UART_BAUD_INVALID);
+    CHECK(uart_get_baud() == 117647);
+    uart_set_baud(UART_BOOT_BAUD);
+    CHECK(uart_get_baud() == 9615);
+}
+
+int main(void)
+{
+    uart_init(UART_BOOT_BAUD);
+
+    test_integers();
+    test_text();
+    test_counts();
+    test_snprintf();
+    test_custom_sink();
+    test_tx_ring();
+    test_rx();
+    test_readline();
+    test_baud();
+
+    printf("%d checks, %d failures\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,18 @@
+/*
+ * UFMT must keep its format string out of .rodata, which this target
+ * copies into SRAM with .data. make host-test compiles this file at -O0
+ * (PROFILE=debug) and -Os, and scripts/rodata_check.py fails the build
+ * if .rodata holds anything but the literal segments (PROGMEM on the
+ * target, plain .rodata on the host).
+ */
+
+#include "ufmt.hpp"
+
+// Single characters, multi-character literals, %% and every conversion
+void ufmt_rodata(uint8_t b, unsigned u, long l, char c, const char* s)
+{
+    UFMT("sig=%X\r\nn=%u!", b, u);
+    UFMT("%d%%%ld %lu %c %s %S %p\r\n", (int)u, l, (unsigned long)l, c, s,
+         ufmt::P(s), (const void*)s);
+    UFMT("x");
+}